@@ -36,7 +36,7 @@
 #endif
 
 SIM_SERIAL_TYPE simSerial = SIM_SERIAL;
-SIM808 sim808 = SIM808(SIM_RST, SIM_PWR, SIM_STATUS);
+SIM808Buffered<> sim808(SIM_RST, SIM_PWR, SIM_STATUS);
 char position[POSITION_SIZE];
 
 void setup() {
@@ -33,7 +33,7 @@
 #define NL  "\n"
 
 SIM_SERIAL_TYPE simSerial = SIM_SERIAL;
-SIM808 sim808 = SIM808(SIM_RST, SIM_PWR, SIM_STATUS);
+SIM808Buffered<> sim808(SIM_RST, SIM_PWR, SIM_STATUS);
 bool done = false;
 char buffer[BUFFER_SIZE];
 
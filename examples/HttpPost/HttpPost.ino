@@ -37,7 +37,8 @@
 #define NL  "\n"
 
 SIM_SERIAL_TYPE simSerial = SIM_SERIAL;
-SIM808 sim808 = SIM808(SIM_RST, SIM_PWR, SIM_STATUS);
+SIM808Buffered<> sim808(SIM_RST, SIM_PWR, SIM_STATUS);
+SIM808ConnectionManager connection = SIM808ConnectionManager(sim808);
 bool done = false;
 char buffer[BUFFER_SIZE];
 
@@ -50,7 +51,10 @@ void setup() {
 
     Log.notice(S_F("Powering on SIM808..." NL));
     sim808.powerOnOff(true);
-    sim808.init();    
+    sim808.init();
+
+    Log.notice(S_F("Connecting..." NL));
+    connection.begin(GPRS_APN, GPRS_USER, GPRS_PASS);
 }
 
 void loop() {
@@ -59,28 +63,13 @@ void loop() {
         return;
     }
 
-    SIM808NetworkRegistrationState status = sim808.getNetworkRegistrationStatus();
-    SIM808SignalQualityReport report = sim808.getSignalQuality();
-
-    bool isAvailable = static_cast<int8_t>(status) &
-        (static_cast<int8_t>(SIM808NetworkRegistrationState::Registered) | static_cast<int8_t>(SIM808NetworkRegistrationState::Roaming))
-        != 0;
+    // registration, GPRS attach and bearer, retried as needed without blocking loop()
+    if(connection.tick() != SIM808ConnectionState::Connected) return;
 
-    if(!isAvailable) {
-        Log.notice(S_F("No network yet..." NL));
-        delay(NETWORK_DELAY);
-        return;
-    }
-
-    Log.notice(S_F("Network is ready." NL));
+    SIM808SignalQualityReport report = sim808.getSignalQuality();
+    Log.notice(S_F("GPRS is ready." NL));
     Log.notice(S_F("Attenuation : %d dBm, Estimated quality : %d" NL), report.attenuation, report.rssi);
 
-    bool enabled = false;
-	do {
-        Log.notice(S_F("Powering on SIM808's GPRS..." NL));
-        enabled = sim808.enableGprs(GPRS_APN, GPRS_USER, GPRS_PASS);        
-    } while(!enabled);
-    
     Log.notice(S_F("Sending HTTP request..." NL));
     STRLCPY_P(buffer, PSTR("This is the body"));
     //notice that we're using the same buffer for both body and response
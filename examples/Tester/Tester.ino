@@ -80,7 +80,7 @@ namespace strings {
 };
 
 SIM_SERIAL_TYPE simSerial = SIM_SERIAL;
-SIM808 sim808 = SIM808(SIM_RST, SIM_PWR, SIM_STATUS);
+SIM808Buffered<> sim808(SIM_RST, SIM_PWR, SIM_STATUS);
 char buffer[BUFFER_SIZE];
 
 void usage() {
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SIM808.h>
+#include "Test.h"
+#include "SIM808Emulator.h"
+
+#define TEST_RESET_PIN 2
+#define TEST_PWRKEY_PIN 3
+#define TEST_STATUS_PIN 4
+
+/**
+ * SIM808 opening up the AT engine to the tests.
+ */
+template<typename Base>
+class Probe : public Base
+{
+public:
+	using Base::Base;
+
+	using SIMComAT::replyBuffer;
+	using SIMComAT::replyBufferSize;
+	using SIMComAT::sendAT;
+	using SIMComAT::sendCommandAT;
+	using SIMComAT::sendFormatAT;
+	using SIMComAT::waitResponse;
+	using SIMComAT::beginBatch;
+	using SIMComAT::batchAT;
+	using SIMComAT::endBatch;
+	using SIMComAT::endBatchAsync;
+	using SIMComAT::find;
+	using SIMComAT::parse;
+	using SIMComAT::parseReply;
+	using SIMComAT::parseReplyFields;
+};
+
+typedef Probe<SIM808Buffered<>> SIM808Probe;
+
+/**
+ * An emulated device wired to a SIM808, through all its pins.
+ */
+template<typename Device = SIM808Probe>
+struct Bench
+{
+	SIM808Emulator modem;
+	Device sim;
+
+	Bench() : sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN)
+	{
+		modem.attachPins(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN);
+		sim.begin(modem);
+	}
+};
+
+/**
+ * Stream reading from and writing to memory, standing for the sketch side of transfers.
+ */
+class MemoryStream : public Stream
+{
+public:
+	std::string input;
+	std::string output;
+	size_t position;
+
+	MemoryStream(const std::string& input = "") : input(input), position(0) { }
+
+	int available() { return (int)(input.size() - position); }
+	int read() { return position < input.size() ? (uint8_t)input[position++] : -1; }
+	int peek() { return position < input.size() ? (uint8_t)input[position] : -1; }
+	size_t write(uint8_t c) { output += (char)c; return 1; }
+	using Print::write;
+};
@@ -0,0 +1,46 @@
+#include "Test.h"
+#include <vector>
+
+struct TestCase
+{
+	const char* name;
+	Test::Function function;
+};
+
+static std::vector<TestCase>& registry()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+static bool failed;
+
+Test::Registration::Registration(const char* name, Function function)
+{
+	registry().push_back({ name, function });
+}
+
+void Test::fail(const char* file, int line, const std::string& message)
+{
+	failed = true;
+	printf("  %s:%d: %s\n", file, line, message.c_str());
+}
+
+int main(int argc, char** argv)
+{
+	int failures = 0;
+	int run = 0;
+
+	for(auto& test : registry()) {
+		if(argc > 1 && std::string(test.name).find(argv[1]) == std::string::npos) continue;
+
+		failed = false;
+		test.function();
+		printf("[%s] %s\n", failed ? "FAIL" : " OK ", test.name);
+		failures += failed;
+		run++;
+	}
+
+	printf("%d failed, %d run\n", failures, run);
+	return failures ? 1 : 0;
+}
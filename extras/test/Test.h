@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+/**
+ * Bare test registry, so that the tests build with nothing but a compiler.
+ * Each TEST is run in declaration order by the main of Test.cpp, and stops at its first failed check.
+ */
+namespace Test
+{
+	typedef void (*Function)();
+
+	struct Registration
+	{
+		Registration(const char* name, Function function);
+	};
+
+	/**
+	 * Record the failure of the running test.
+	 */
+	void fail(const char* file, int line, const std::string& message);
+
+	inline std::string describe(const std::string& value) { return "\"" + value + "\""; }
+	inline std::string describe(const char* value) { return value ? describe(std::string(value)) : "NULL"; }
+	inline std::string describe(char* value) { return describe((const char*)value); }
+	inline std::string describe(bool value) { return value ? "true" : "false"; }
+	inline std::string describe(double value) { return std::to_string(value); }
+	template<typename T> std::string describe(T value) { return std::to_string((long long)value); }
+
+	template<typename A, typename B> bool equal(const A& a, const B& b) { return a == b; }
+	inline bool equal(const char* a, const char* b) { return a && b ? std::string(a) == b : a == b; }
+	inline bool equal(char* a, const char* b) { return equal((const char*)a, b); }
+	inline bool equal(const char* a, char* b) { return equal(a, (const char*)b); }
+}
+
+#define TEST(name) \
+	static void test_##name(); \
+	static Test::Registration registration_##name(#name, test_##name); \
+	static void test_##name()
+
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) { \
+			Test::fail(__FILE__, __LINE__, #condition); \
+			return; \
+		} \
+	} while(0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		auto expectedValue = (expected); \
+		auto actualValue = (actual); \
+		if(!Test::equal(expectedValue, actualValue)) { \
+			Test::fail(__FILE__, __LINE__, std::string(#actual " is ") + Test::describe(actualValue) + \
+				", expected " + Test::describe(expectedValue)); \
+			return; \
+		} \
+	} while(0)
@@ -0,0 +1,650 @@
+/**
+ * Runs every public SIM808 method against the emulator, and reports for each one :
+ * - device : time spent on the (virtual) wire and in the device, in ms,
+ * - cpu : host CPU time, in us, library and emulator model together, busy waiting included,
+ * - idle : polls that found nothing to read, the library busy waiting for the device,
+ * - tx / rx : bytes written to and read from the device,
+ * - writes : calls to the port write.
+ *
+ * Then measures the throughput of streams of work, once set up :
+ * - units : lines, fixes or bodies processed, and the bytes they hold,
+ * - device : virtual time spent, for the streams exchanged with the emulator,
+ * - cpu : host CPU time, with the bytes per second and the TSC cycles per unit it gives.
+ *
+ *   sim808_benchmark [--iterations n] [--csv] [filter]
+ */
+
+#include "Fixture.h"
+#include <time.h>
+#include <fstream>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+struct Measure
+{
+	uint32_t iterations;
+	uint32_t succeeded;
+	double device;
+	double cpu;
+	double idle;
+	double tx;
+	double rx;
+	double writes;
+};
+
+struct Case
+{
+	const char* name;
+	std::function<void(Bench<SIM808Buffered<>>& bench)> setup;
+	std::function<bool(Bench<SIM808Buffered<>>& bench)> run;
+};
+
+/**
+ * Measures the part of a rate between begin() and end(). The rate then tells how much work was done.
+ */
+struct Meter
+{
+	uint64_t device;
+	uint64_t cpu;
+	uint64_t cycles;
+	double units;
+	double bytes;
+	char note[64];
+
+	void begin();
+	void end();
+};
+
+struct Rate
+{
+	const char* name;
+	const char* unit;
+	std::function<void(Meter& meter)> run;
+};
+
+static SIM808Emulator* current;
+static char response[256];
+
+static void setHostBaudrate(uint32_t baudrate)
+{
+	current->setHostBaudrate(baudrate);
+}
+
+static size_t produceBody(uint8_t* buffer, size_t size, uint32_t offset)
+{
+	memset(buffer, 'b', size);
+	return size;
+}
+
+static void discardFix(const SIM808GnssFix& fix) { }
+
+static uint32_t replayedFixes;
+static uint32_t replayedPositions;
+
+static void countFix(const SIM808GnssFix& fix)
+{
+	replayedFixes++;
+	replayedPositions += fix.fixStatus;
+}
+
+static uint64_t cpuTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t cycleCount()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+void Meter::begin()
+{
+	note[0] = '\0';
+	device = ArduinoShim::nanos();
+	cpu = cpuTime();
+	cycles = cycleCount();
+}
+
+void Meter::end()
+{
+	cycles = cycleCount() - cycles;
+	cpu = cpuTime() - cpu;
+	device = ArduinoShim::nanos() - device;
+}
+
+static void connected(Bench<SIM808Buffered<>>& bench)
+{
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+}
+
+static void noop(Bench<SIM808Buffered<>>& bench) { }
+
+static std::vector<Case> cases()
+{
+	typedef Bench<SIM808Buffered<>>& B;
+	static SIM808GnssStream stream(discardFix);
+
+	return {
+		{ "powered", noop, [](B b) { return b.sim.powered(); } },
+		{ "powerOnOff", noop, [](B b) { return b.sim.powerOnOff(false); } },
+		{ "init", noop, [](B b) { b.sim.init(); return true; } },
+		{ "init(phase)", noop, [](B b) { return b.sim.init(SIM808BootPhase::Sms, 5000); } },
+		{ "reset", noop, [](B b) { b.sim.reset(); return true; } },
+		{ "waitForBoot", [](B b) { b.sim.reset(); }, [](B b) { return b.sim.waitForBoot(SIM808BootPhase::Sms, 5000); } },
+		{ "getBootTimings", noop, [](B b) { b.sim.getBootTimings(); return true; } },
+		{ "getChargingState", noop, [](B b) { return b.sim.getChargingState().state != SIM808ChargingState::Error; } },
+		{ "getPhoneFunctionality", noop, [](B b) { return b.sim.getPhoneFunctionality() != SIM808PhoneFunctionality::Fail; } },
+		{ "setPhoneFunctionality", noop, [](B b) { return b.sim.setPhoneFunctionality(SIM808PhoneFunctionality::Full); } },
+		{ "setSlowClock", noop, [](B b) { return b.sim.setSlowClock(SIM808SlowClock::Enable); } },
+		{ "sendCommand", noop, [](B b) { return b.sim.sendCommand("+GSN", response, sizeof(response)) > 0; } },
+		{ "setEcho", noop, [](B b) { return b.sim.setEcho(SIM808Echo::Off); } },
+		{ "detectBaudrate", [](B b) { b.modem.setBaudrate(9600); }, [](B b) { return b.sim.detectBaudrate(setHostBaudrate) == 9600; } },
+		{ "negotiateBaudrate", [](B b) { b.modem.setBaudrate(9600); }, [](B b) { return b.sim.negotiateBaudrate(setHostBaudrate) == 115200; } },
+		{ "simUnlock", [](B b) { b.modem.simLocked = true; b.modem.pin = "1234"; }, [](B b) { return b.sim.simUnlock("1234"); } },
+		{ "getSimState", noop, [](B b) { return b.sim.getSimState(response, sizeof(response)) > 0; } },
+		{ "getImei", noop, [](B b) { return b.sim.getImei(response, sizeof(response)) > 0; } },
+		{ "getSignalQuality", noop, [](B b) { return b.sim.getSignalQuality().rssi != 99; } },
+		{ "setSmsMessageFormat", noop, [](B b) { return b.sim.setSmsMessageFormat(SIM808SmsMessageFormat::Text); } },
+		{ "sendSms", noop, [](B b) { return b.sim.sendSms("+33600000000", "Hello from the benchmark"); } },
+		{ "getGprsPowerState", noop, [](B b) { bool state; return b.sim.getGprsPowerState(&state); } },
+		{ "enableGprs", noop, [](B b) { return b.sim.enableGprs("internet", "user", "password"); } },
+		{ "disableGprs", connected, [](B b) { return b.sim.disableGprs(); } },
+		{ "openSockets", [](B b) { b.modem.attached = true; }, [](B b) { return b.sim.openSockets("internet"); } },
+		{ "closeSockets", noop, [](B b) { return b.sim.closeSockets(); } },
+		{ "getNetworkRegistrationStatus", noop, [](B b) { return b.sim.getNetworkRegistrationStatus() != SIM808NetworkRegistrationState::Error; } },
+		{ "setNetworkRegistrationUrc", noop, [](B b) { return b.sim.setNetworkRegistrationUrc(SIM808RegistrationUrc::Enable); } },
+		{ "getGpsPowerState", noop, [](B b) { bool state; return b.sim.getGpsPowerState(&state); } },
+		{ "powerOnOffGps", noop, [](B b) { return b.sim.powerOnOffGps(true); } },
+		// the satellites used are past the end of the default reply buffer, telling a fix from an accurate one takes a larger one
+		{ "getGpsStatus", [](B b) { b.modem.gnssPower = true; }, [](B b) { return b.sim.getGpsStatus(response, sizeof(response)) >= SIM808GpsStatus::Fix; } },
+		{ "getGpsField", noop, [](B b) { uint16_t value; return b.sim.getGpsField("1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,", SIM808GpsField::GnssUsed, &value); } },
+		{ "getGpsPosition", [](B b) { b.modem.gnssPower = true; }, [](B b) { return b.sim.getGpsPosition(response, sizeof(response)); } },
+		{ "getGpsFix", [](B b) { b.modem.gnssPower = true; }, [](B b) { SIM808GnssFix fix; return b.sim.getGpsFix(&fix) == SIM808GpsStatus::AccurateFix; } },
+		{ "parseGpsFix", noop, [](B b) { SIM808GnssFix fix; return SIM808::parseGpsFix("1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,", &fix); } },
+		{ "getCellLocation", connected, [](B b) { SIM808GnssFix fix; return b.sim.getCellLocation(&fix); } },
+		{ "startGpsStream", noop, [](B b) { return b.sim.startGpsStream(stream); } },
+		{ "stopGpsStream", [](B b) { b.sim.startGpsStream(stream); }, [](B b) { return b.sim.stopGpsStream(); } },
+		{ "httpGet", connected, [](B b) { return b.sim.httpGet("http://example.com/", response, sizeof(response)) == 200; } },
+		{ "httpGet(Print)", connected, [](B b) { MemoryStream out; return b.sim.httpGet("http://example.com/", out) == 200; } },
+		{ "httpPost", connected, [](B b) { return b.sim.httpPost("http://example.com/", "text/plain", "body", response, sizeof(response)) == 200; } },
+		{ "httpPost(Stream)", connected, [](B b) { MemoryStream body(std::string(4096, 'b')); return b.sim.httpPost("http://example.com/", "text/plain", body, 4096, response, sizeof(response)) == 200; } },
+		{ "httpPost(producer)", connected, [](B b) { return b.sim.httpPost("http://example.com/", "text/plain", produceBody, 4096, response, sizeof(response)) == 200; } },
+		{ "sendCommandAsync", noop, [](B b) {
+			if(!b.sim.sendCommandAsync("+CSQ")) return false;
+			while(b.sim.poll() == SIMComATResponseStatus::Pending);
+			return b.sim.responseResult() == 0;
+		} },
+	};
+}
+
+/**
+ * Lines a chatty device sends while a +CSQ response is awaited, the last one being the response.
+ */
+static std::string tokenizerInput(uint32_t responses, uint32_t* lines)
+{
+	static const char* group[] = {
+		"+CREG: 1,\"00C1\",\"1A2B\"",
+		"+CGNSPWR: 1",
+		"+UGNSINF: 1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,",
+		"OK",
+		"+CSQ: 21,0"
+	};
+	std::string input;
+
+	for(uint32_t i = 0; i < responses; i++) {
+		for(const char* line : group) input += std::string("\r\n") + line + "\r\n";
+	}
+
+	*lines = responses * (sizeof(group) / sizeof(group[0]));
+	return input;
+}
+
+/**
+ * waitResponse as it was before awaited tokens were matched while bytes arrive : each line is read
+ * whole into a cleared buffer, checking available() before each character, then searched for every token.
+ * port is the SIM808 itself, reading from the device as readNext did.
+ */
+static int8_t legacyWaitResponse(Stream& port, char* buffer, size_t size, const char* s1, const char* s2)
+{
+	const char* tokens[2] = { s1, s2 };
+
+	while(port.available()) {
+		size_t length = 0;
+		bool exit = false;
+
+		memset(buffer, 0, size);
+		while(!exit && length < size - 1 && port.available()) {
+			char c = port.read();
+			buffer[length++] = c;
+			exit = c == '\n';
+		}
+
+		if(length <= 1) continue;
+
+		for(uint8_t i = 0; i < 2; i++) {
+			if(strstr(buffer, tokens[i]) == buffer) return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * +CGNSINF sequences, with and without a fix.
+ */
+static const char* const GNSS_SEQUENCES[] = {
+	"1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,",
+	"1,1,20190325161343.000,48.858412,2.294563,35.100,4.81,87.5,1,,0.9,1.2,0.8,,12,9,3,,41,,",
+	"1,0,20190325161300.000,,,,0.00,0.0,0,,,,,,8,0,,,,,",
+	"1,1,20190325161344.000,-33.856784,151.215297,5.400,12.96,241.3,1,,1.1,1.5,1.0,,11,7,2,,39,,"
+};
+
+#define GNSS_SEQUENCES_COUNT (sizeof(GNSS_SEQUENCES) / sizeof(GNSS_SEQUENCES[0]))
+#define GNSS_ROUNDS 5000
+
+static double gnssSequencesBytes()
+{
+	double bytes = 0;
+	for(const char* sequence : GNSS_SEQUENCES) bytes += strlen(sequence);
+
+	return bytes * GNSS_ROUNDS;
+}
+
+/**
+ * +UGNSINF lines pushed by a device reporting every second, cold start included, as received.
+ * Empty if bench/ugnsinf.txt cannot be read.
+ */
+static const std::string& gnssCapture(uint32_t* lines)
+{
+	static std::string capture;
+	static uint32_t count = 0;
+
+	if(capture.empty()) {
+		std::ifstream file(BENCH_DIR "/ugnsinf.txt");
+		std::string line;
+
+		while(std::getline(file, line)) {
+			capture += "\r\n" + line + "\r\n";
+			count++;
+		}
+	}
+
+	*lines = count;
+	return capture;
+}
+
+#define GNSS_CAPTURE_ROUNDS 20
+#define FIX_FRAME_SIZE 256		///< Size of the frames fixes are uploaded in, as in the README.
+
+/**
+ * Parse the sequences of the capture, adding up their length without header nor new line.
+ */
+static std::vector<SIM808GnssFix> captureFixes(double* textBytes)
+{
+	std::vector<SIM808GnssFix> fixes;
+	uint32_t lines;
+	const std::string& capture = gnssCapture(&lines);
+	const std::string header = "+UGNSINF: ";
+	size_t start = 0;
+
+	*textBytes = 0;
+	while((start = capture.find(header, start)) != std::string::npos) {
+		SIM808GnssFix fix;
+
+		start += header.size();
+		std::string sequence = capture.substr(start, capture.find('\r', start) - start);
+		SIM808::parseGpsFix(sequence.c_str(), &fix);
+
+		fixes.push_back(fix);
+		*textBytes += sequence.size();
+	}
+
+	return fixes;
+}
+
+/**
+ * Push fixes through a ring, and pop them as FIX_FRAME_SIZE frames once it is full and at the end.
+ */
+static std::vector<std::string> frameFixes(const std::vector<SIM808GnssFix>& fixes, uint32_t rounds)
+{
+	static SIM808StaticFixRing<1024> ring;
+	std::vector<std::string> frames;
+	uint8_t frame[FIX_FRAME_SIZE];
+	size_t length;
+
+	for(uint32_t i = 0; i < rounds; i++) {
+		for(const SIM808GnssFix& fix : fixes) {
+			while(!ring.push(fix) && (length = ring.popFrame(frame, sizeof(frame)))) frames.push_back(std::string((char*)frame, length));
+		}
+	}
+
+	while((length = ring.popFrame(frame, sizeof(frame)))) frames.push_back(std::string((char*)frame, length));
+	return frames;
+}
+
+#define HTTP_READ_BODY_SIZE 65536
+
+/**
+ * Stream a HTTP_READ_BODY_SIZE bytes response with both ends of the link at baudrate,
+ * each command answered with the default latency of the emulator.
+ */
+static void httpReadAt(Meter& m, uint32_t baudrate)
+{
+	Bench<SIM808Buffered<>> bench;
+	MemoryStream output;
+	std::string body(HTTP_READ_BODY_SIZE, 'b');
+
+	connected(bench);
+	bench.modem.setBaudrate(baudrate);
+	bench.modem.setHostBaudrate(baudrate);
+	bench.modem.setHttpServer([&body](const EmulatorHttpRequest& request, std::string& response) {
+		response = body;
+		return (uint16_t)200;
+	});
+
+	m.begin();
+	bool succeeded = bench.sim.httpGet("http://example.com/", output) == 200;
+	m.end();
+
+	m.units = succeeded;
+	m.bytes = output.output.size();
+	// 10 bits on the wire per byte
+	snprintf(m.note, sizeof(m.note), "%.0f%% of the wire", m.bytes * 1e9 / m.device * 10 / baudrate * 100);
+}
+
+#define HTTP_POST_BODY_SIZE 65536
+
+/**
+ * Post a HTTP_POST_BODY_SIZE bytes body at the default baudrate, from a stream or from a producer.
+ */
+static void httpPost(Meter& m, bool stream)
+{
+	Bench<SIM808Buffered<>> bench;
+	MemoryStream body(std::string(HTTP_POST_BODY_SIZE, 'b'));
+	size_t received = 0;
+
+	connected(bench);
+	bench.modem.setHttpServer([&received](const EmulatorHttpRequest& request, std::string& response) {
+		received = request.body.size();
+		return (uint16_t)200;
+	});
+	bench.modem.clearObservations();
+
+	m.begin();
+	uint16_t status = stream ?
+		bench.sim.httpPost("http://example.com/", "application/octet-stream", body, HTTP_POST_BODY_SIZE, response, sizeof(response)) :
+		bench.sim.httpPost("http://example.com/", "application/octet-stream", produceBody, HTTP_POST_BODY_SIZE, response, sizeof(response));
+	m.end();
+
+	m.units = status == 200;
+	m.bytes = received;
+	snprintf(m.note, sizeof(m.note), "%u writes, %.0f bytes each",
+		bench.modem.writeCalls, bench.modem.bytesWritten / (double)bench.modem.writeCalls);
+}
+
+static std::vector<Rate> rates()
+{
+	typedef Meter& M;
+
+	return {
+		{ "tokenizer (line then strstr)", "lines", [](M m) {
+			uint32_t lines;
+			MemoryStream port(tokenizerInput(2000, &lines));
+			SIM808Probe sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN);
+			char buffer[SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE];
+			uint32_t responses = 0;
+
+			sim.begin(port);
+			m.begin();
+			while(legacyWaitResponse(sim, buffer, sizeof(buffer), "+CSQ", "ERROR") == 0) responses++;
+			m.end();
+
+			m.units = lines;
+			m.bytes = port.input.size();
+			snprintf(m.note, sizeof(m.note), "%u responses", responses);
+		} },
+		{ "tokenizer (incremental)", "lines", [](M m) {
+			uint32_t lines;
+			MemoryStream port(tokenizerInput(2000, &lines));
+			SIM808Probe sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN);
+			uint32_t responses = 0;
+
+			sim.begin(port);
+			m.begin();
+			while(port.available() && sim.waitResponse(1000, TO_F("+CSQ")) == 0) responses++;
+			m.end();
+
+			m.units = lines;
+			m.bytes = port.input.size();
+			snprintf(m.note, sizeof(m.note), "%u responses", responses);
+		} },
+		{ "GPS fields (getGpsField)", "fixes", [](M m) {
+			SIM808Probe sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN);
+			uint32_t fixes = 0;
+
+			// the fields the Tester example reads, each one searched for from the start of the sequence
+			m.begin();
+			for(uint32_t i = 0; i < GNSS_ROUNDS; i++) {
+				for(const char* sequence : GNSS_SEQUENCES) {
+					char* utc;
+					float latitude, longitude, altitude, speed, course;
+					uint16_t inView, used;
+
+					sim.getGpsField(sequence, SIM808GpsField::Utc, &utc);
+					sim.getGpsField(sequence, SIM808GpsField::Latitude, &latitude);
+					sim.getGpsField(sequence, SIM808GpsField::Longitude, &longitude);
+					sim.getGpsField(sequence, SIM808GpsField::Altitude, &altitude);
+					sim.getGpsField(sequence, SIM808GpsField::Speed, &speed);
+					sim.getGpsField(sequence, SIM808GpsField::Course, &course);
+					sim.getGpsField(sequence, SIM808GpsField::GpsInView, &inView);
+					sim.getGpsField(sequence, SIM808GpsField::GnssUsed, &used);
+					fixes += used > 0;
+				}
+			}
+			m.end();
+
+			m.units = GNSS_ROUNDS * GNSS_SEQUENCES_COUNT;
+			m.bytes = gnssSequencesBytes();
+			snprintf(m.note, sizeof(m.note), "8 fields, %u fixes", fixes);
+		} },
+		{ "GPS fields (GnssParser)", "fixes", [](M m) {
+			uint32_t fixes = 0;
+
+			m.begin();
+			for(uint32_t i = 0; i < GNSS_ROUNDS; i++) {
+				for(const char* sequence : GNSS_SEQUENCES) {
+					SIM808GnssFix fix;
+
+					SIM808::parseGpsFix(sequence, &fix);
+					fixes += fix.gnssUsed > 0;
+				}
+			}
+			m.end();
+
+			m.units = GNSS_ROUNDS * GNSS_SEQUENCES_COUNT;
+			m.bytes = gnssSequencesBytes();
+			snprintf(m.note, sizeof(m.note), "all fields, %u fixes", fixes);
+		} },
+		{ "+UGNSINF replay", "fixes", [](M m) {
+			uint32_t lines;
+			const std::string& capture = gnssCapture(&lines);
+			std::string input;
+			SIM808Probe sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, TEST_STATUS_PIN);
+			SIM808GnssStream stream(countFix);
+
+			for(uint32_t i = 0; i < GNSS_CAPTURE_ROUNDS; i++) input += capture;
+			MemoryStream port(input);
+
+			sim.begin(port);
+			sim.registerUrcHandler(TO_F("+UGNSINF: "), stream);
+			replayedFixes = replayedPositions = 0;
+
+			m.begin();
+			while(port.available()) sim.poll();
+			m.end();
+
+			m.units = replayedFixes;
+			m.bytes = input.size();
+			snprintf(m.note, sizeof(m.note), "%u with a position, %u s captured", replayedPositions, lines * GNSS_CAPTURE_ROUNDS);
+		} },
+		{ "fix ring (push, popFrame)", "fixes", [](M m) {
+			double textBytes;
+			std::vector<SIM808GnssFix> fixes = captureFixes(&textBytes);
+			std::vector<std::string> frames;
+			double frameBytes = 0;
+
+			m.begin();
+			frames = frameFixes(fixes, GNSS_CAPTURE_ROUNDS);
+			m.end();
+
+			for(auto& frame : frames) frameBytes += frame.size();
+
+			// bytes are the text sequences the frames stand for
+			m.units = fixes.size() * GNSS_CAPTURE_ROUNDS;
+			m.bytes = textBytes * GNSS_CAPTURE_ROUNDS;
+			snprintf(m.note, sizeof(m.note), "%.1f B/fix, %.1f:1 of text, %.1f:1 of struct",
+				frameBytes / m.units, m.bytes / frameBytes, m.units * sizeof(SIM808GnssFix) / frameBytes);
+		} },
+		{ "fix ring (decode)", "fixes", [](M m) {
+			double textBytes;
+			std::vector<std::string> frames = frameFixes(captureFixes(&textBytes), GNSS_CAPTURE_ROUNDS);
+			uint32_t fixes = 0;
+
+			m.bytes = 0;
+			m.begin();
+			for(auto& frame : frames) {
+				// every frame starts with a keyframe, and is decoded on its own
+				SIM808FixDecoder decoder;
+				SIM808GnssFix fix;
+				const uint8_t* data = (const uint8_t*)frame.data() + 1;
+				size_t remaining = frame.size() - 1;
+				uint8_t length;
+
+				while((length = decoder.decode(data, remaining, &fix))) {
+					data += length;
+					remaining -= length;
+					fixes++;
+				}
+
+				m.bytes += frame.size();
+			}
+			m.end();
+
+			m.units = fixes;
+			snprintf(m.note, sizeof(m.note), "%u frames of %u bytes at most", (uint32_t)frames.size(), FIX_FRAME_SIZE);
+		} },
+		{ "HTTP read at 9600", "bodies", [](M m) { httpReadAt(m, 9600); } },
+		{ "HTTP read at 19200", "bodies", [](M m) { httpReadAt(m, 19200); } },
+		{ "HTTP read at 38400", "bodies", [](M m) { httpReadAt(m, 38400); } },
+		{ "HTTP read at 57600", "bodies", [](M m) { httpReadAt(m, 57600); } },
+		{ "HTTP read at 115200", "bodies", [](M m) { httpReadAt(m, 115200); } },
+		{ "HTTP read at 230400", "bodies", [](M m) { httpReadAt(m, 230400); } },
+		{ "HTTP read at 460800", "bodies", [](M m) { httpReadAt(m, 460800); } },
+		{ "HTTP post (Stream)", "bodies", [](M m) { httpPost(m, true); } },
+		{ "HTTP post (producer)", "bodies", [](M m) { httpPost(m, false); } },
+	};
+}
+
+static void printRates(uint32_t iterations, bool csv, const char* filter)
+{
+	printf(csv ?
+		"\nrate,unit,units,bytes,device_ms,cpu_us,device_bytes_per_s,cpu_bytes_per_s,cpu_units_per_s,cycles_per_unit,note\n" :
+		"\n%-30s %6s %8s %9s %10s %10s %11s %11s %11s %10s  %s\n",
+		"rate", "unit", "units", "bytes", "device ms", "cpu us", "device B/s", "cpu B/s", "cpu units/s", "cycles/u", "note");
+
+	for(auto& r : rates()) {
+		double device = 0, cpu = 0, cycles = 0, units = 0, bytes = 0;
+		Meter m;
+
+		if(filter && !strstr(r.name, filter)) continue;
+
+		for(uint32_t i = 0; i < iterations; i++) {
+			m.units = m.bytes = 0;
+			r.run(m);
+
+			device += m.device / 1e9;
+			cpu += m.cpu / 1e9;
+			cycles += m.cycles;
+			units += m.units;
+			bytes += m.bytes;
+		}
+
+		if(!iterations) continue;
+
+		// a stream that never reached the device has no device rate
+		printf(csv ?
+			"%s,%s,%.0f,%.0f,%.1f,%.1f,%.0f,%.0f,%.0f,%.1f,%s\n" :
+			"%-30s %6s %8.0f %9.0f %10.1f %10.1f %11.0f %11.0f %11.0f %10.1f  %s\n",
+			r.name, r.unit, units / iterations, bytes / iterations,
+			device * 1e3 / iterations, cpu * 1e6 / iterations,
+			device > 0 ? bytes / device : 0, cpu > 0 ? bytes / cpu : 0, cpu > 0 ? units / cpu : 0,
+			units > 0 ? cycles / units : 0, m.note);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t iterations = 10;
+	bool csv = false;
+	const char* filter = NULL;
+
+	for(int i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--csv")) csv = true;
+		else filter = argv[i];
+	}
+
+	printf(csv ?
+		"method,succeeded,iterations,device_ms,cpu_us,idle,tx,rx,writes\n" :
+		"%-30s %9s %10s %10s %8s %8s %8s %7s\n", "method", "succeeded", "device ms", "cpu us", "idle", "tx", "rx", "writes");
+
+	for(auto& c : cases()) {
+		Measure m = {};
+
+		if(filter && !strstr(c.name, filter)) continue;
+
+		for(uint32_t i = 0; i < iterations; i++) {
+			Bench<SIM808Buffered<>> bench;
+			current = &bench.modem;
+
+			c.setup(bench);
+			bench.modem.clearObservations();
+
+			uint64_t device = ArduinoShim::nanos();
+			uint64_t cpu = cpuTime();
+			bool succeeded = c.run(bench);
+			cpu = cpuTime() - cpu;
+			device = ArduinoShim::nanos() - device;
+
+			m.iterations++;
+			m.succeeded += succeeded;
+			m.device += device / 1e6;
+			m.cpu += cpu / 1e3;
+			m.idle += bench.modem.idlePolls;
+			m.tx += bench.modem.bytesWritten;
+			m.rx += bench.modem.bytesRead;
+			m.writes += bench.modem.writeCalls;
+		}
+
+		if(!m.iterations) continue;
+
+		printf(csv ?
+			"%s,%u,%u,%.1f,%.1f,%.0f,%.0f,%.0f,%.0f\n" :
+			"%-30s %5u/%-3u %10.1f %10.1f %8.0f %8.0f %8.0f %7.0f\n",
+			c.name, m.succeeded, m.iterations,
+			m.device / m.iterations, m.cpu / m.iterations, m.idle / m.iterations,
+			m.tx / m.iterations, m.rx / m.iterations, m.writes / m.iterations);
+	}
+
+	printRates(iterations, csv, filter);
+	return 0;
+}
@@ -0,0 +1,960 @@
+#include "SIM808Emulator.h"
+#include <algorithm>
+#include <cctype>
+
+#define NS_PER_MS 1000000ULL
+#define IDLE_STEP NS_PER_MS		///< Longest move of the clock on a poll with nothing to read.
+#define HOST_TX_BUFFER_SIZE 64	///< Bytes the host UART holds before a write blocks, as HardwareSerial does.
+
+typedef std::lock_guard<std::recursive_mutex> Lock;
+
+static const char* const BOOT_LINES[EMULATOR_BOOT_PHASES] = {
+	"RDY",
+	"+CFUN: 1",
+	"+CPIN: READY",
+	"Call Ready",
+	"SMS Ready"
+};
+
+static const uint32_t BAUDRATES[] = {
+	0, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800
+};
+
+static std::string number(long value)
+{
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), "%ld", value);
+	return buffer;
+}
+
+static long toNumber(const std::vector<std::string>& parameters, size_t index)
+{
+	return index < parameters.size() ? strtol(parameters[index].c_str(), NULL, 10) : -1;
+}
+
+SIM808Emulator::SIM808Emulator()
+{
+	imei = "861234567890123";
+	rssi = 20;
+	ber = 0;
+	chargeState = 0;
+	chargeLevel = 85;
+	voltage = 4100;
+	registration = 1;
+	bearerAddress = "10.54.12.7";
+	localAddress = "10.54.12.8";
+	simLocked = false;
+	gnssFix = "1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,";
+	cellLocation = "2.294420,48.858260,2019/03/25,16:13:40";
+	maxReliableBaudrate = 460800;
+
+	const uint16_t timings[EMULATOR_BOOT_PHASES] = { 250, 600, 900, 2500, 3000 };
+	memcpy(bootTimings, timings, sizeof(bootTimings));
+
+	_deviceBaudrate = _bootBaudrate = _hostBaudrate = 115200;
+	_defaultLatency = 20;
+	_noise = 1;
+	_generation = 0;
+	_gnssGeneration = 0;
+	_outputEnd = _inputEnd = _replyAt = ArduinoShim::nanos();
+	_powered = true;
+	_ready = true;
+	_resetPin = _pwrKeyPin = _statusPin = 255;
+	_pwrKeyPressed = 0;
+	_pwrKeyHeld = false;
+	_resetHeld = false;
+
+	// time taken by the device and the network before answering
+	setLatency("+CGATT=", 1000);
+	setLatency("+SAPBR=1", 1500);
+	setLatency("+SAPBR=0", 500);
+	setLatency("+CIPSHUT", 300);
+	setLatency("+CIICR", 800);
+	setLatency("+CIPGSMLOC", 1500);
+	setLatency("+HTTPACTION:", 1200);
+	setLatency("CONNECT OK", 400);
+	setLatency("+RECEIVE", 100);
+	setLatency("+CMGS:", 2000);
+
+	restoreDefaults();
+	// left as SIM808::init leaves it
+	echo = false;
+
+	installDefaultHandlers();
+	clearObservations();
+}
+
+SIM808Emulator::~SIM808Emulator()
+{
+	if(_resetPin != 255 || _pwrKeyPin != 255 || _statusPin != 255) {
+		ArduinoShim::onDigitalWrite(nullptr);
+		ArduinoShim::onDigitalRead(nullptr);
+	}
+}
+
+void SIM808Emulator::restoreDefaults()
+{
+	echo = true;
+	errorReporting = 0;
+	functionality = 1;
+	registrationUrc = 0;
+	attached = false;
+	bearerOpen = false;
+	bearerSettings.clear();
+	gnssPower = false;
+	httpInitialized = false;
+	httpParameters.clear();
+	httpSsl = false;
+	multiConnection = false;
+	ipUp = false;
+	for(uint8_t i = 0; i < EMULATOR_MAX_LINKS; i++) linkOpen[i] = false;
+
+	_line.clear();
+	_errorCode = -1;
+	_dataRemaining = 0;
+	_dataUntil = false;
+	_dataReceived = nullptr;
+	_gnssPeriod = 0;
+	_gnssGeneration++;
+}
+
+void SIM808Emulator::clearObservations()
+{
+	Lock lock(_mutex);
+
+	wire.clear();
+	commands.clear();
+	writeCalls = 0;
+	bytesWritten = 0;
+	bytesRead = 0;
+	idlePolls = 0;
+}
+
+void SIM808Emulator::attachPins(uint8_t resetPin, uint8_t pwrKeyPin, uint8_t statusPin)
+{
+	_resetPin = resetPin;
+	_pwrKeyPin = pwrKeyPin;
+	_statusPin = statusPin;
+
+	ArduinoShim::onDigitalWrite([this](uint8_t pin, uint8_t value) { writePin(pin, value); });
+	ArduinoShim::onDigitalRead([this](uint8_t pin) { return readPin(pin); });
+}
+
+void SIM808Emulator::setBaudrate(uint32_t baudrate)
+{
+	Lock lock(_mutex);
+	_deviceBaudrate = _bootBaudrate = baudrate;
+}
+
+void SIM808Emulator::setHostBaudrate(uint32_t baudrate)
+{
+	Lock lock(_mutex);
+	_hostBaudrate = baudrate;
+}
+
+void SIM808Emulator::on(const std::string& prefix, Handler handler)
+{
+	Lock lock(_mutex);
+
+	for(auto& entry : _handlers) {
+		if(entry.first != prefix) continue;
+
+		entry.second = handler;
+		return;
+	}
+
+	_handlers.push_back(std::make_pair(prefix, handler));
+	std::stable_sort(_handlers.begin(), _handlers.end(), [](const std::pair<std::string, Handler>& a, const std::pair<std::string, Handler>& b) {
+		return a.first.size() > b.first.size();
+	});
+}
+
+void SIM808Emulator::respond(const std::string& prefix, const std::string& raw)
+{
+	on(prefix, [raw](SIM808Emulator& e, const std::string& command) {
+		e.replyRaw(raw);
+		return EmulatorResult::Handled;
+	});
+}
+
+void SIM808Emulator::fail(const std::string& prefix, uint16_t times, int16_t code)
+{
+	Lock lock(_mutex);
+	_failures[prefix] = { times, code };
+}
+
+SIM808Emulator::Handler* SIM808Emulator::findHandler(const std::string& command, std::string* key)
+{
+	for(auto& entry : _handlers) {
+		if(command.compare(0, entry.first.size(), entry.first)) continue;
+
+		if(key) *key = entry.first;
+		return &entry.second;
+	}
+
+	return NULL;
+}
+
+uint32_t SIM808Emulator::latency(const std::string& command)
+{
+	size_t longest = 0;
+	uint32_t result = _defaultLatency;
+
+	for(auto& entry : _latencies) {
+		if(entry.first.size() < longest || command.compare(0, entry.first.size(), entry.first)) continue;
+
+		longest = entry.first.size();
+		result = entry.second;
+	}
+
+	return result;
+}
+
+std::vector<std::string> SIM808Emulator::parameters(const std::string& command)
+{
+	std::vector<std::string> result;
+	size_t start = command.find('=');
+	bool quoted = false;
+	std::string current;
+
+	if(start == std::string::npos) return result;
+
+	for(size_t i = start + 1; i < command.size(); i++) {
+		char c = command[i];
+
+		if(c == '"') quoted = !quoted;
+		else if(c == ',' && !quoted) {
+			result.push_back(current);
+			current.clear();
+		}
+		else current += c;
+	}
+
+	result.push_back(current);
+	return result;
+}
+
+#pragma region Output
+
+uint64_t SIM808Emulator::byteTime(uint32_t baudrate)
+{
+	// start, 8 data bits and stop
+	return baudrate ? 10ULL * 1000000000ULL / baudrate : 0;
+}
+
+bool SIM808Emulator::linkUsable()
+{
+	return _powered && _deviceBaudrate && _deviceBaudrate == _hostBaudrate;
+}
+
+void SIM808Emulator::queue(const std::string& raw, uint64_t at)
+{
+	if(!linkUsable() || raw.empty()) return;
+
+	Chunk chunk;
+	chunk.start = std::max(at, _outputEnd);
+	chunk.byteTime = byteTime(_deviceBaudrate);
+	chunk.data = raw;
+	chunk.position = 0;
+
+	if(_hostBaudrate > maxReliableBaudrate) {
+		for(char& c : chunk.data) {
+			_noise = _noise * 1664525 + 1013904223;
+			if((_noise >> 24) < 32) c ^= 0x20 | (_noise & 0x0F);
+		}
+	}
+
+	_outputEnd = chunk.start + chunk.byteTime * raw.size();
+	_output.push_back(chunk);
+}
+
+void SIM808Emulator::schedule(uint64_t at, std::function<void()> run, bool survivesRestart)
+{
+	_timers.push_back({ at, survivesRestart ? UINT32_MAX : _generation, run });
+}
+
+void SIM808Emulator::pump()
+{
+	uint64_t now = ArduinoShim::nanos();
+
+	for(;;) {
+		auto due = _timers.end();
+		for(auto it = _timers.begin(); it != _timers.end(); ++it) {
+			if(it->at <= now && (due == _timers.end() || it->at < due->at)) due = it;
+		}
+
+		if(due == _timers.end()) return;
+
+		Timer timer = *due;
+		_timers.erase(due);
+		if(timer.generation == _generation || timer.generation == UINT32_MAX) timer.run();
+	}
+}
+
+size_t SIM808Emulator::ready()
+{
+	uint64_t now = ArduinoShim::nanos();
+
+	pump();
+
+	while(!_output.empty()) {
+		Chunk& chunk = _output.front();
+		if(chunk.position == chunk.data.size()) {
+			_output.pop_front();
+			continue;
+		}
+
+		if(now < chunk.start) return 0;
+
+		size_t received = std::min(chunk.data.size(), (size_t)((now - chunk.start) / chunk.byteTime));
+		return received > chunk.position ? received - chunk.position : 0;
+	}
+
+	return 0;
+}
+
+void SIM808Emulator::idle()
+{
+	uint64_t now = ArduinoShim::nanos();
+	uint64_t next = now + IDLE_STEP;
+
+	idlePolls++;
+
+	if(!_output.empty()) {
+		const Chunk& chunk = _output.front();
+		next = std::min(next, chunk.start + (chunk.position + 1) * chunk.byteTime);
+	}
+
+	for(auto& timer : _timers) next = std::min(next, timer.at);
+
+	ArduinoShim::advance(next > now ? next - now : 0);
+}
+
+void SIM808Emulator::drainInput()
+{
+	uint64_t now = ArduinoShim::nanos();
+	uint64_t buffered = HOST_TX_BUFFER_SIZE * byteTime(_hostBaudrate);
+
+	// the write returns once the bytes left fit in the host buffer
+	if(_inputEnd > now + buffered) ArduinoShim::advance(_inputEnd - buffered - now);
+}
+
+void SIM808Emulator::send(const std::string& raw, uint32_t delay)
+{
+	Lock lock(_mutex);
+	uint64_t at = ArduinoShim::nanos() + delay * NS_PER_MS;
+
+	if(!delay) queue(raw, at);
+	else schedule(at, [this, raw, at]() { queue(raw, at); });
+}
+
+void SIM808Emulator::urc(const std::string& line, uint32_t delay)
+{
+	send("\r\n" + line + "\r\n", delay);
+}
+
+void SIM808Emulator::receive(uint8_t link, const std::string& data, uint32_t delay)
+{
+	send("\r\n+RECEIVE," + number(link) + "," + number(data.size()) + ":\r\n" + data, delay);
+}
+
+void SIM808Emulator::closeRemote(uint8_t link, uint32_t delay)
+{
+	Lock lock(_mutex);
+
+	linkOpen[link] = false;
+	urc(number(link) + ", CLOSED", delay);
+}
+
+void SIM808Emulator::reply(const std::string& line)
+{
+	replyRaw("\r\n" + line + "\r\n");
+}
+
+void SIM808Emulator::replyRaw(const std::string& raw)
+{
+	queue(raw, _replyAt);
+}
+
+void SIM808Emulator::replyLater(const std::string& line, uint32_t delay)
+{
+	uint64_t at = _replyAt + delay * NS_PER_MS;
+	schedule(at, [this, line, at]() { queue("\r\n" + line + "\r\n", at); });
+}
+
+#pragma endregion
+
+#pragma region Input
+
+void SIM808Emulator::expectData(size_t length, std::function<void(const std::string& data)> received)
+{
+	_data.clear();
+	_dataRemaining = length;
+	_dataUntil = false;
+	_dataReceived = received;
+
+	if(!length) received(_data);
+}
+
+void SIM808Emulator::expectDataUntil(char terminator, std::function<void(const std::string& data)> received)
+{
+	_data.clear();
+	_dataTerminator = terminator;
+	_dataUntil = true;
+	_dataReceived = received;
+}
+
+void SIM808Emulator::receiveByte(uint8_t c)
+{
+	uint64_t now = ArduinoShim::nanos();
+
+	wire += (char)c;
+	bytesWritten++;
+	_inputEnd = std::max(_inputEnd, now) + byteTime(_hostBaudrate);
+
+	if(!_powered) return;
+
+	if(_dataReceived) {
+		bool complete;
+
+		if(_dataUntil) {
+			complete = c == (uint8_t)_dataTerminator;
+			if(!complete) _data += (char)c;
+		}
+		else {
+			_data += (char)c;
+			complete = !--_dataRemaining;
+		}
+
+		if(!complete) return;
+
+		std::function<void(const std::string& data)> received = _dataReceived;
+		_dataReceived = nullptr;
+		_dataUntil = false;
+		_replyAt = _inputEnd + _defaultLatency * NS_PER_MS;
+		received(_data);
+		return;
+	}
+
+	if(echo && _ready) queue(std::string(1, (char)c), _inputEnd);
+
+	if(c != '\r' && c != '\n') {
+		_line += (char)c;
+		return;
+	}
+
+	if(_line.empty()) return;
+
+	std::string line = _line;
+	_line.clear();
+	runLine(line);
+}
+
+void SIM808Emulator::runLine(const std::string& line)
+{
+	EmulatorResult result = EmulatorResult::Ok;
+	std::vector<std::string> batch;
+	std::string current;
+	bool quoted = false;
+
+	if(!_ready) return;
+	if(line.size() < 2 || toupper(line[0]) != 'A' || toupper(line[1]) != 'T') return;
+
+	// autobauding locks on the first AT received
+	if(!_deviceBaudrate) _deviceBaudrate = _hostBaudrate;
+	if(_deviceBaudrate != _hostBaudrate) return;
+
+	if(_hostBaudrate > maxReliableBaudrate) {
+		_noise = _noise * 1664525 + 1013904223;
+		if(_noise >> 31) return;
+	}
+
+	commands.push_back(line);
+
+	for(size_t i = 2; i < line.size(); i++) {
+		if(line[i] == '"') quoted = !quoted;
+		if(line[i] == ';' && !quoted) {
+			batch.push_back(current);
+			current.clear();
+		}
+		else current += line[i];
+	}
+	if(!current.empty() || batch.empty()) batch.push_back(current);
+
+	_replyAt = _inputEnd;
+	_errorCode = -1;
+
+	for(auto& command : batch) {
+		result = runCommand(command);
+		if(result != EmulatorResult::Ok) break;
+	}
+
+	if(result == EmulatorResult::Ok) reply("OK");
+	else if(result == EmulatorResult::Error) {
+		if(errorReporting == 1 && _errorCode >= 0) reply("+CME ERROR: " + number(_errorCode));
+		else reply("ERROR");
+	}
+}
+
+EmulatorResult SIM808Emulator::runCommand(const std::string& command)
+{
+	std::string key;
+
+	_replyAt = std::max(_replyAt, _inputEnd) + latency(command) * NS_PER_MS;
+	if(command.empty()) return EmulatorResult::Ok;
+
+	for(auto& failure : _failures) {
+		if(!failure.second.times || command.compare(0, failure.first.size(), failure.first)) continue;
+
+		failure.second.times--;
+		_errorCode = failure.second.code;
+		return EmulatorResult::Error;
+	}
+
+	Handler* handler = findHandler(command, &key);
+	if(!handler) return EmulatorResult::Error;
+
+	return (*handler)(*this, command);
+}
+
+#pragma endregion
+
+#pragma region Power
+
+void SIM808Emulator::boot()
+{
+	uint64_t now = ArduinoShim::nanos();
+
+	_ready = false;
+	for(uint8_t i = 0; i < EMULATOR_BOOT_PHASES; i++) {
+		uint64_t at = now + bootTimings[i] * NS_PER_MS;
+
+		schedule(at, [this, i, at]() {
+			if(!i) _ready = true;
+			queue(std::string("\r\n") + BOOT_LINES[i] + "\r\n", at);
+		});
+	}
+}
+
+void SIM808Emulator::reset()
+{
+	Lock lock(_mutex);
+
+	_generation++;
+	_output.clear();
+	_outputEnd = ArduinoShim::nanos();
+	_deviceBaudrate = _bootBaudrate;
+	restoreDefaults();
+
+	if(_powered) boot();
+}
+
+void SIM808Emulator::setPowered(bool powered)
+{
+	Lock lock(_mutex);
+
+	if(powered == _powered) return;
+
+	_powered = powered;
+	reset();
+	if(!powered) _ready = false;
+}
+
+void SIM808Emulator::writePin(uint8_t pin, uint8_t value)
+{
+	Lock lock(_mutex);
+	uint64_t now = ArduinoShim::nanos();
+
+	pump();
+
+	if(pin == _resetPin) {
+		if(value == LOW) _resetHeld = true;
+		else if(_resetHeld) {
+			_resetHeld = false;
+			reset();
+		}
+	}
+
+	if(pin == _pwrKeyPin) {
+		if(value == LOW && !_pwrKeyHeld) {
+			_pwrKeyHeld = true;
+			_pwrKeyPressed = now;
+		}
+		else if(value == HIGH && _pwrKeyHeld) {
+			_pwrKeyHeld = false;
+			if(now - _pwrKeyPressed >= 1000 * NS_PER_MS) setPowered(!_powered);
+		}
+	}
+}
+
+int SIM808Emulator::readPin(uint8_t pin)
+{
+	Lock lock(_mutex);
+	bool powered = _powered;
+
+	if(pin != _statusPin) return LOW;
+
+	// the status follows as soon as the key has been held long enough
+	if(_pwrKeyHeld && ArduinoShim::nanos() - _pwrKeyPressed >= 1000 * NS_PER_MS) powered = !powered;
+	return powered ? HIGH : LOW;
+}
+
+#pragma endregion
+
+#pragma region Stream implementation
+
+int SIM808Emulator::available()
+{
+	Lock lock(_mutex);
+	size_t count = ready();
+
+	if(!count) {
+		idle();
+		count = ready();
+	}
+
+	return (int)std::min(count, (size_t)INT16_MAX);
+}
+
+int SIM808Emulator::read()
+{
+	Lock lock(_mutex);
+
+	if(!ready()) idle();
+	if(!ready()) return -1;
+
+	Chunk& chunk = _output.front();
+	bytesRead++;
+	return (uint8_t)chunk.data[chunk.position++];
+}
+
+int SIM808Emulator::peek()
+{
+	Lock lock(_mutex);
+
+	if(!ready()) return -1;
+
+	Chunk& chunk = _output.front();
+	return (uint8_t)chunk.data[chunk.position];
+}
+
+size_t SIM808Emulator::write(uint8_t c)
+{
+	Lock lock(_mutex);
+
+	pump();
+	writeCalls++;
+	receiveByte(c);
+	drainInput();
+
+	return 1;
+}
+
+size_t SIM808Emulator::write(const uint8_t* buffer, size_t size)
+{
+	Lock lock(_mutex);
+
+	pump();
+	writeCalls++;
+	for(size_t i = 0; i < size; i++) receiveByte(buffer[i]);
+	drainInput();
+
+	return size;
+}
+
+#pragma endregion
+
+#pragma region Default model
+
+void SIM808Emulator::scheduleGnssReport(uint64_t at, uint32_t generation)
+{
+	schedule(at, [this, at, generation]() {
+		if(generation != _gnssGeneration || !_gnssPeriod) return;
+
+		if(gnssPower) queue("\r\n+UGNSINF: " + gnssFix + "\r\n", at);
+		scheduleGnssReport(at + _gnssPeriod * 1000 * NS_PER_MS, generation);
+	});
+}
+
+EmulatorResult SIM808Emulator::httpAction(uint8_t method)
+{
+	EmulatorHttpRequest request;
+	uint16_t status;
+
+	request.method = method;
+	request.url = httpParameters["URL"];
+	request.userAgent = httpParameters["UA"];
+	request.contentType = httpParameters["CONTENT"];
+	request.body = method == 1 ? httpBody : "";
+	request.ssl = httpSsl;
+	httpRequests.push_back(request);
+
+	httpResponse.clear();
+	if(!bearerOpen) status = 601;
+	else if(_httpServer) status = _httpServer(request, httpResponse);
+	else {
+		status = 200;
+		httpResponse = "OK";
+	}
+
+	replyLater("+HTTPACTION: " + number(method) + "," + number(status) + "," + number(httpResponse.size()), latency("+HTTPACTION:"));
+	return EmulatorResult::Ok;
+}
+
+void SIM808Emulator::installDefaultHandlers()
+{
+	typedef SIM808Emulator E;
+	typedef EmulatorResult R;
+	typedef const std::string& C;
+
+#pragma region General
+
+	on("E", [](E& e, C c) { e.echo = c.size() > 1 && c[1] == '1'; return R::Ok; });
+	on("+CMEE=", [](E& e, C c) { e.errorReporting = toNumber(parameters(c), 0); return R::Ok; });
+	on("+IPR=", [](E& e, C c) {
+		uint32_t baudrate = toNumber(parameters(c), 0);
+		if(std::find(std::begin(BAUDRATES), std::end(BAUDRATES), baudrate) == std::end(BAUDRATES)) return R::Error;
+
+		// acknowledged at the current baudrate
+		e.reply("OK");
+		e._deviceBaudrate = baudrate;
+		return R::Handled;
+	});
+	on("+CFUN?", [](E& e, C c) { e.reply("+CFUN: " + number(e.functionality)); return R::Ok; });
+	on("+CFUN=", [](E& e, C c) { e.functionality = toNumber(parameters(c), 0); return R::Ok; });
+	on("+CSCLK=", [](E& e, C c) { return R::Ok; });
+	on("+CBC", [](E& e, C c) {
+		e.reply("+CBC: " + number(e.chargeState) + "," + number(e.chargeLevel) + "," + number(e.voltage));
+		return R::Ok;
+	});
+	on("+GSN", [](E& e, C c) { e.reply(e.imei); return R::Ok; });
+
+#pragma endregion
+
+#pragma region GSM
+
+	on("+CPIN?", [](E& e, C c) { e.reply(e.simLocked ? "+CPIN: SIM PIN" : "+CPIN: READY"); return R::Ok; });
+	on("+CPIN=", [](E& e, C c) {
+		if(!e.simLocked) {
+			e.setErrorCode(3);
+			return R::Error;
+		}
+
+		if(parameters(c)[0] != e.pin) {
+			e.setErrorCode(16);
+			return R::Error;
+		}
+
+		e.simLocked = false;
+		return R::Ok;
+	});
+	on("+CSQ", [](E& e, C c) { e.reply("+CSQ: " + number(e.rssi) + "," + number(e.ber)); return R::Ok; });
+	on("+CMGF=", [](E& e, C c) { return R::Ok; });
+	on("+CMGS=", [](E& e, C c) {
+		e.replyRaw("\r\n> ");
+		e.expectDataUntil(0x1A, [&e](const std::string& text) {
+			e.smsSent.push_back(text);
+			e._replyAt += e.latency("+CMGS:") * NS_PER_MS;
+			e.reply("+CMGS: " + number(e.smsSent.size()));
+			e.reply("OK");
+		});
+		return R::Handled;
+	});
+
+#pragma endregion
+
+#pragma region GPRS
+
+	on("+CGREG?", [](E& e, C c) { e.reply("+CGREG: " + number(e.registrationUrc) + "," + number(e.registration)); return R::Ok; });
+	on("+CGREG=", [](E& e, C c) { e.registrationUrc = toNumber(parameters(c), 0); return R::Ok; });
+	on("+CGATT?", [](E& e, C c) { e.reply("+CGATT: " + number(e.attached)); return R::Ok; });
+	on("+CGATT=", [](E& e, C c) {
+		bool attach = toNumber(parameters(c), 0) == 1;
+		if(attach && e.registration != 1 && e.registration != 5) return R::Error;
+
+		e.attached = attach;
+		if(!attach) e.bearerOpen = e.ipUp = false;
+		return R::Ok;
+	});
+	on("+SAPBR=", [](E& e, C c) {
+		std::vector<std::string> p = parameters(c);
+
+		switch(toNumber(p, 0)) {
+			case 0:
+				if(!e.bearerOpen) return R::Error;
+				e.bearerOpen = false;
+				return R::Ok;
+			case 1:
+				if(!e.attached || e.bearerOpen) return R::Error;
+				e.bearerOpen = true;
+				return R::Ok;
+			case 2:
+				e.reply("+SAPBR: 1," + std::string(e.bearerOpen ? "1" : "3") + ",\"" + (e.bearerOpen ? e.bearerAddress : "0.0.0.0") + "\"");
+				return R::Ok;
+			case 3:
+				if(p.size() != 4) return R::Error;
+				e.bearerSettings[p[2]] = p[3];
+				return R::Ok;
+			case 4:
+				return R::Ok;
+		}
+
+		return R::Error;
+	});
+	on("+CIPSHUT", [](E& e, C c) {
+		e.ipUp = false;
+		for(uint8_t i = 0; i < EMULATOR_MAX_LINKS; i++) e.linkOpen[i] = false;
+
+		e.reply("SHUT OK");
+		return R::Handled;
+	});
+
+#pragma endregion
+
+#pragma region HTTP
+
+	on("+HTTPINIT", [](E& e, C c) {
+		if(e.httpInitialized) return R::Error;
+
+		e.httpInitialized = true;
+		e.httpParameters.clear();
+		e.httpSsl = false;
+		e.httpBody.clear();
+		return R::Ok;
+	});
+	on("+HTTPTERM", [](E& e, C c) {
+		if(!e.httpInitialized) return R::Error;
+
+		e.httpInitialized = false;
+		return R::Ok;
+	});
+	on("+HTTPPARA=", [](E& e, C c) {
+		std::vector<std::string> p = parameters(c);
+		if(!e.httpInitialized || p.size() != 2) return R::Error;
+
+		e.httpParameters[p[0]] = p[1];
+		return R::Ok;
+	});
+	on("+HTTPSSL=", [](E& e, C c) {
+		if(!e.httpInitialized) return R::Error;
+
+		e.httpSsl = toNumber(parameters(c), 0) == 1;
+		return R::Ok;
+	});
+	on("+HTTPDATA=", [](E& e, C c) {
+		long size = toNumber(parameters(c), 0);
+		if(!e.httpInitialized || size < 0) return R::Error;
+
+		e.reply("DOWNLOAD");
+		e.expectData(size, [&e](const std::string& data) {
+			e.httpBody = data;
+			e.reply("OK");
+		});
+		return R::Handled;
+	});
+	on("+HTTPACTION=", [](E& e, C c) {
+		long method = toNumber(parameters(c), 0);
+		if(!e.httpInitialized || method < 0 || method > 2) return R::Error;
+
+		return e.httpAction(method);
+	});
+	on("+HTTPREAD", [](E& e, C c) {
+		std::vector<std::string> p = parameters(c);
+		size_t offset = p.size() == 2 ? toNumber(p, 0) : 0;
+		size_t size = p.size() == 2 ? toNumber(p, 1) : e.httpResponse.size();
+		if(!e.httpInitialized) return R::Error;
+
+		std::string data = offset < e.httpResponse.size() ? e.httpResponse.substr(offset, size) : "";
+		e.replyRaw("\r\n+HTTPREAD: " + number(data.size()) + "\r\n" + data + "\r\nOK\r\n");
+		return R::Handled;
+	});
+
+#pragma endregion
+
+#pragma region GNSS
+
+	on("+CGNSPWR?", [](E& e, C c) { e.reply("+CGNSPWR: " + number(e.gnssPower)); return R::Ok; });
+	on("+CGNSPWR=", [](E& e, C c) { e.gnssPower = toNumber(parameters(c), 0) == 1; return R::Ok; });
+	on("+CGNSINF", [](E& e, C c) {
+		e.reply("+CGNSINF: " + (e.gnssPower ? e.gnssFix : std::string("0,,,,,,,,,,,,,,,,,,,,")));
+		return R::Ok;
+	});
+	on("+CGNSURC=", [](E& e, C c) {
+		long period = toNumber(parameters(c), 0);
+		if(period < 0 || period > 255) return R::Error;
+
+		e._gnssPeriod = period;
+		e._gnssGeneration++;
+		if(period) e.scheduleGnssReport(e._replyAt + period * 1000 * NS_PER_MS, e._gnssGeneration);
+		return R::Ok;
+	});
+	on("+CIPGSMLOC=", [](E& e, C c) {
+		e.reply(e.bearerOpen ? "+CIPGSMLOC: 0," + e.cellLocation : "+CIPGSMLOC: 601");
+		return R::Ok;
+	});
+
+#pragma endregion
+
+#pragma region TCP/IP
+
+	on("+CIPMUX=", [](E& e, C c) {
+		if(e.ipUp) return R::Error;
+
+		e.multiConnection = toNumber(parameters(c), 0) == 1;
+		return R::Ok;
+	});
+	on("+CIPQSEND=", [](E& e, C c) { return R::Ok; });
+	on("+CSTT=", [](E& e, C c) { return e.ipUp ? R::Error : R::Ok; });
+	on("+CIICR", [](E& e, C c) {
+		if(!e.attached || e.ipUp) return R::Error;
+
+		e.ipUp = true;
+		return R::Ok;
+	});
+	on("+CIFSR", [](E& e, C c) {
+		if(!e.ipUp) return R::Error;
+
+		// the address is the whole response
+		e.reply(e.localAddress);
+		return R::Handled;
+	});
+	on("+CIPSTART=", [](E& e, C c) {
+		long link = toNumber(parameters(c), 0);
+		if(!e.ipUp || !e.multiConnection || link < 0 || link >= EMULATOR_MAX_LINKS) return R::Error;
+		if(e.linkOpen[link]) {
+			e.replyLater(number(link) + ", ALREADY CONNECT", 0);
+			return R::Ok;
+		}
+
+		e.linkOpen[link] = true;
+		e.replyLater(number(link) + ", CONNECT OK", e.latency("CONNECT OK"));
+		return R::Ok;
+	});
+	on("+CIPSEND=", [](E& e, C c) {
+		std::vector<std::string> p = parameters(c);
+		long link = toNumber(p, 0);
+		long size = toNumber(p, 1);
+		if(link < 0 || link >= EMULATOR_MAX_LINKS || !e.linkOpen[link] || size <= 0) return R::Error;
+
+		e.replyRaw("\r\n> ");
+		e.expectData(size, [&e, link](const std::string& data) {
+			e.replyLater("DATA ACCEPT:" + number(link) + "," + number(data.size()), e.latency("DATA ACCEPT"));
+
+			if(e._socketPeer) e._socketPeer(link, data);
+			else e.receive(link, data, e.latency("+RECEIVE"));
+		});
+		return R::Handled;
+	});
+	on("+CIPCLOSE=", [](E& e, C c) {
+		long link = toNumber(parameters(c), 0);
+		if(link < 0 || link >= EMULATOR_MAX_LINKS || !e.linkOpen[link]) return R::Error;
+
+		e.linkOpen[link] = false;
+		e.reply(number(link) + ", CLOSE OK");
+		return R::Handled;
+	});
+
+#pragma endregion
+}
+
+#pragma endregion
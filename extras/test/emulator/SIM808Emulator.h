@@ -0,0 +1,322 @@
+#pragma once
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define EMULATOR_BOOT_PHASES 5
+#define EMULATOR_MAX_LINKS 6
+
+/**
+ * Outcome of an emulated command.
+ */
+enum class EmulatorResult : uint8_t
+{
+	Ok = 0,		///< The command succeeded, OK follows its replies unless more batched commands remain.
+	Error = 1,	///< The command failed, ERROR or +CME ERROR ends the line.
+	Handled = 2	///< The command has written its whole response itself, or is waiting for data.
+};
+
+/**
+ * HTTP request fired by AT+HTTPACTION, as set up with AT+HTTPPARA and AT+HTTPDATA.
+ */
+struct EmulatorHttpRequest
+{
+	uint8_t method;
+	std::string url;
+	std::string userAgent;
+	std::string contentType;
+	std::string body;
+	bool ssl;
+};
+
+/**
+ * Scriptable model of a SIM808 behind a Stream, to run the library on the host.
+ *
+ * Commands written by the library are answered from handlers keyed by command prefix
+ * ("+CSQ", "+CGATT=", "E"...). Every command has a default handler modelling the device state,
+ * which tests can replace with on() or respond(), or make fail with fail().
+ * Responses are paced by the baudrate and delayed by a per-command latency, on the virtual
+ * clock of the Arduino shim. While the library polls with nothing to read, the clock moves
+ * forward by at most 1 ms, so that timeouts expire as they would on a board.
+ *
+ * Batched commands (';' separated) are run one after the other, stopping at the first failure.
+ */
+class SIM808Emulator : public Stream
+{
+public:
+	typedef std::function<EmulatorResult(SIM808Emulator& emulator, const std::string& command)> Handler;
+	typedef std::function<uint16_t(const EmulatorHttpRequest& request, std::string& body)> HttpServer;
+	typedef std::function<void(uint8_t link, const std::string& data)> SocketPeer;
+
+#pragma region Model
+
+	bool echo;
+	uint8_t errorReporting;		///< AT+CMEE mode.
+	uint8_t functionality;		///< AT+CFUN mode.
+	std::string pin;			///< PIN unlocking the SIM, or empty if the SIM is not locked.
+	bool simLocked;
+	std::string imei;
+	uint8_t rssi;
+	uint8_t ber;
+	uint8_t chargeState;
+	uint8_t chargeLevel;
+	uint16_t voltage;
+	uint8_t registrationUrc;	///< AT+CGREG mode.
+	uint8_t registration;		///< Network registration status, see SIM808NetworkRegistrationState.
+	bool attached;
+	bool bearerOpen;
+	std::string bearerAddress;
+	std::map<std::string, std::string> bearerSettings;
+	bool gnssPower;
+	std::string gnssFix;		///< Parsed sequence answered to +CGNSINF and pushed with +UGNSINF while powered.
+	std::string cellLocation;	///< Fields of a successful +CIPGSMLOC, "<longitude>,<latitude>,<date>,<time>".
+
+	bool httpInitialized;
+	std::map<std::string, std::string> httpParameters;
+	bool httpSsl;
+	std::string httpBody;		///< Body downloaded with the last AT+HTTPDATA.
+	std::string httpResponse;	///< Body of the last response, read with AT+HTTPREAD.
+	std::vector<EmulatorHttpRequest> httpRequests;	///< Every request fired so far.
+
+	bool multiConnection;
+	bool ipUp;
+	std::string localAddress;
+	bool linkOpen[EMULATOR_MAX_LINKS];
+	std::vector<std::string> smsSent;
+
+	uint16_t bootTimings[EMULATOR_BOOT_PHASES];	///< Time at which each boot line is sent after a reset or power on, in ms.
+	uint32_t maxReliableBaudrate;	///< Lines are corrupted above this baudrate.
+
+#pragma endregion
+
+#pragma region Observations
+
+	std::string wire;					///< Every byte written by the library.
+	std::vector<std::string> commands;	///< Every command line received, without its new line.
+	uint32_t writeCalls;				///< Calls to write, whatever their size.
+	uint64_t bytesWritten;				///< Bytes written by the library.
+	uint64_t bytesRead;					///< Bytes read by the library.
+	uint64_t idlePolls;					///< Polls with nothing to read.
+
+	/**
+	 * Forget everything observed so far.
+	 */
+	void clearObservations();
+
+#pragma endregion
+
+	SIM808Emulator();
+	~SIM808Emulator();
+
+	/**
+	 * Listen to the pins driven by the library, and answer the status pin.
+	 * Pins that are not connected are SIM808_UNAVAILABLE_PIN.
+	 */
+	void attachPins(uint8_t resetPin, uint8_t pwrKeyPin, uint8_t statusPin);
+	/**
+	 * Set the baudrate the device is using, or 0 for autobauding.
+	 */
+	void setBaudrate(uint32_t baudrate);
+	uint32_t baudrate() { return _deviceBaudrate; }
+	/**
+	 * Set the baudrate the host UART is configured to. Nothing gets through while both differ.
+	 */
+	void setHostBaudrate(uint32_t baudrate);
+	uint32_t hostBaudrate() { return _hostBaudrate; }
+
+	/**
+	 * Set the time taken by the device to answer every command without a latency of its own.
+	 */
+	void setDefaultLatency(uint32_t ms) { _defaultLatency = ms; }
+	/**
+	 * Set the time taken by the device to answer the commands starting with command.
+	 * Results pushed later are keyed by their own prefix ("+HTTPACTION:", "CONNECT OK", "+RECEIVE").
+	 */
+	void setLatency(const std::string& command, uint32_t ms) { _latencies[command] = ms; }
+
+	/**
+	 * Replace the handler of every command starting with prefix.
+	 */
+	void on(const std::string& prefix, Handler handler);
+	/**
+	 * Answer every command starting with prefix with raw, written as is.
+	 */
+	void respond(const std::string& prefix, const std::string& raw);
+	/**
+	 * Make the next times commands starting with prefix fail, with a +CME ERROR if code is not negative.
+	 */
+	void fail(const std::string& prefix, uint16_t times = 1, int16_t code = -1);
+	/**
+	 * Answer the HTTP requests fired from now on.
+	 */
+	void setHttpServer(HttpServer server) { _httpServer = server; }
+	/**
+	 * Receive the data sent over every link, instead of echoing it back.
+	 */
+	void setSocketPeer(SocketPeer peer) { _socketPeer = peer; }
+
+	/**
+	 * Send an unsolicited line, delay ms from now.
+	 */
+	void urc(const std::string& line, uint32_t delay = 0);
+	/**
+	 * Send raw bytes, delay ms from now.
+	 */
+	void send(const std::string& raw, uint32_t delay = 0);
+	/**
+	 * Push data received from the remote end of link.
+	 */
+	void receive(uint8_t link, const std::string& data, uint32_t delay = 0);
+	/**
+	 * Close link from the remote end.
+	 */
+	void closeRemote(uint8_t link, uint32_t delay = 0);
+	/**
+	 * Restart the device, as if its reset pin has been pulsed.
+	 */
+	void reset();
+	/**
+	 * Turn the device on or off, as if its power key has been pulsed.
+	 */
+	void setPowered(bool powered);
+	bool powered() { return _powered; }
+
+#pragma region Handler helpers
+
+	/**
+	 * Send line as a response line of the command being run.
+	 */
+	void reply(const std::string& line);
+	/**
+	 * Send raw bytes as part of the response of the command being run.
+	 */
+	void replyRaw(const std::string& raw);
+	/**
+	 * Send line delay ms after the response of the command being run, unless the device restarts in between.
+	 */
+	void replyLater(const std::string& line, uint32_t delay);
+	/**
+	 * Hand the next length raw bytes written by the library over to received, instead of reading commands.
+	 */
+	void expectData(size_t length, std::function<void(const std::string& data)> received);
+	/**
+	 * Hand the raw bytes written by the library over to received up to terminator, excluded.
+	 */
+	void expectDataUntil(char terminator, std::function<void(const std::string& data)> received);
+	/**
+	 * Set the +CME ERROR code of the command failing.
+	 */
+	void setErrorCode(int16_t code) { _errorCode = code; }
+	/**
+	 * Get the latency of command.
+	 */
+	uint32_t latency(const std::string& command);
+	/**
+	 * Split the parameters of command, following '=', and unquote them.
+	 */
+	static std::vector<std::string> parameters(const std::string& command);
+
+#pragma endregion
+
+#pragma region Stream implementation
+
+	int available();
+	int read();
+	int peek();
+	size_t write(uint8_t c);
+	size_t write(const uint8_t* buffer, size_t size);
+	using Print::write;
+	void flush() { }
+
+#pragma endregion
+
+private:
+	struct Chunk
+	{
+		uint64_t start;		///< Time at which the first byte starts being sent, in ns.
+		uint64_t byteTime;	///< Time taken by each byte on the wire, in ns.
+		std::string data;
+		size_t position;	///< Bytes already read.
+	};
+
+	struct Timer
+	{
+		uint64_t at;
+		uint32_t generation;	///< Boot generation the timer belongs to, forgotten on restart.
+		std::function<void()> run;
+	};
+
+	struct Failure
+	{
+		uint16_t times;
+		int16_t code;
+	};
+
+	std::recursive_mutex _mutex;
+	std::vector<std::pair<std::string, Handler>> _handlers;	///< Longest prefix first.
+	std::map<std::string, uint32_t> _latencies;
+	std::map<std::string, Failure> _failures;
+	HttpServer _httpServer;
+	SocketPeer _socketPeer;
+
+	std::deque<Chunk> _output;
+	std::vector<Timer> _timers;
+	uint64_t _outputEnd;		///< Time at which the last byte queued is sent.
+	uint64_t _inputEnd;			///< Time at which the last byte written by the library is received.
+	uint64_t _replyAt;			///< Time at which the response of the command being run is sent.
+	uint32_t _generation;
+
+	uint32_t _deviceBaudrate;
+	uint32_t _bootBaudrate;		///< Baudrate used again after a restart, AT+IPR not being saved.
+	uint32_t _hostBaudrate;
+	uint32_t _defaultLatency;
+	uint32_t _noise;			///< State of the generator corrupting lines at unreliable baudrates.
+
+	bool _powered;
+	bool _ready;				///< The device answers commands.
+	uint8_t _resetPin;
+	uint8_t _pwrKeyPin;
+	uint8_t _statusPin;
+	uint64_t _pwrKeyPressed;	///< Time at which the power key has been pressed.
+	bool _pwrKeyHeld;
+	bool _resetHeld;
+
+	std::string _line;
+	int16_t _errorCode;
+	size_t _dataRemaining;
+	char _dataTerminator;
+	bool _dataUntil;
+	std::string _data;
+	std::function<void(const std::string& data)> _dataReceived;
+
+	uint32_t _gnssPeriod;
+	uint32_t _gnssGeneration;
+
+	void installDefaultHandlers();
+	Handler* findHandler(const std::string& command, std::string* key);
+
+	uint64_t byteTime(uint32_t baudrate);
+	bool linkUsable();
+	void queue(const std::string& raw, uint64_t at);
+	void schedule(uint64_t at, std::function<void()> run, bool survivesRestart = false);
+	void pump();
+	size_t ready();
+	void idle();
+	void drainInput();
+
+	void receiveByte(uint8_t c);
+	void runLine(const std::string& line);
+	EmulatorResult runCommand(const std::string& command);
+	void restoreDefaults();
+	void boot();
+	void scheduleGnssReport(uint64_t at, uint32_t generation);
+	void writePin(uint8_t pin, uint8_t value);
+	int readPin(uint8_t pin);
+
+	EmulatorResult httpAction(uint8_t method);
+};
@@ -0,0 +1,146 @@
+#include "Arduino.h"
+#include <atomic>
+
+HostSerial Serial;
+
+static std::atomic<uint64_t> now(0);
+static std::function<void(uint8_t, uint8_t)> writeListener;
+static std::function<int(uint8_t)> readListener;
+
+uint64_t ArduinoShim::nanos()
+{
+	return now;
+}
+
+void ArduinoShim::advance(uint64_t ns)
+{
+	now += ns;
+}
+
+void ArduinoShim::onDigitalWrite(std::function<void(uint8_t pin, uint8_t value)> listener)
+{
+	writeListener = listener;
+}
+
+void ArduinoShim::onDigitalRead(std::function<int(uint8_t pin)> reader)
+{
+	readListener = reader;
+}
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+	size_t length = strlen(src);
+
+	if(size) {
+		size_t copied = length < size - 1 ? length : size - 1;
+		memcpy(dst, src, copied);
+		dst[copied] = '\0';
+	}
+
+	return length;
+}
+#endif
+
+uint32_t millis()
+{
+	return (uint32_t)(now / 1000000);
+}
+
+uint32_t micros()
+{
+	return (uint32_t)(now / 1000);
+}
+
+void delay(uint32_t ms)
+{
+	now += (uint64_t)ms * 1000000;
+}
+
+void yield() { }
+
+void pinMode(uint8_t pin, uint8_t mode) { }
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if(writeListener) writeListener(pin, value);
+}
+
+int digitalRead(uint8_t pin)
+{
+	return readListener ? readListener(pin) : LOW;
+}
+
+static uint32_t seed = 1;
+
+long random(long max)
+{
+	// deterministic runs, whatever the host libc
+	seed = seed * 1103515245 + 12345;
+	return max > 0 ? (long)((seed >> 8) % (uint32_t)max) : 0;
+}
+
+long random(long min, long max)
+{
+	return min < max ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long value)
+{
+	seed = value;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+size_t Print::print(long value, int base)
+{
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), base == HEX ? "%lx" : "%ld", value);
+	return write(buffer);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), base == HEX ? "%lx" : "%lu", value);
+	return write(buffer);
+}
+
+size_t Print::print(double value, int digits)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write(buffer);
+}
+
+int Stream::timedRead()
+{
+	uint32_t start = millis();
+
+	do {
+		int c = read();
+		if(c >= 0) return c;
+
+		// the virtual time would never reach the timeout otherwise
+		delay(1);
+	} while(millis() - start < _timeout);
+
+	return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+	size_t count = 0;
+
+	while(count < length) {
+		int c = timedRead();
+		if(c < 0) break;
+
+		buffer[count++] = (char)c;
+	}
+
+	return count;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+/**
+ * Minimal Arduino core, just enough to build the library on the host.
+ * Time is virtual : it only moves forward with delay() and while a SIM808Emulator
+ * is polled with nothing to read, so that runs are deterministic whatever the host load.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <functional>
+#include <type_traits>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strstr_P strstr
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define strlcpy_P strlcpy
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+
+class __FlashStringHelper;
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+template<typename A, typename B> typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template<typename A, typename B> typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+/**
+ * Hooks of the virtual board, driven by the tests and the emulator.
+ */
+namespace ArduinoShim
+{
+	/**
+	 * Get the virtual time elapsed since the program started, in ns.
+	 */
+	uint64_t nanos();
+	/**
+	 * Move the virtual time forward.
+	 */
+	void advance(uint64_t ns);
+	/**
+	 * Receive every digitalWrite, or nothing if listener is empty.
+	 */
+	void onDigitalWrite(std::function<void(uint8_t pin, uint8_t value)> listener);
+	/**
+	 * Answer every digitalRead, or LOW if reader is empty.
+	 */
+	void onDigitalRead(std::function<int(uint8_t pin)> reader);
+}
+
+class Print
+{
+public:
+	virtual ~Print() { }
+
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size)
+	{
+		size_t n = 0;
+		while(size--) n += write(*buffer++);
+		return n;
+	}
+	size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+	size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+	virtual void flush() { }
+
+	size_t print(const char* str) { return write(str); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+	size_t print(int value, int base = DEC) { return print((long)value, base); }
+	size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+
+	size_t println() { return print("\r\n"); }
+	template<typename T> size_t println(T value) { return print(value) + println(); }
+};
+
+class Stream : public Print
+{
+protected:
+	unsigned long _timeout = 1000;
+
+	int timedRead();
+
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+	size_t readBytes(char* buffer, size_t length);
+	size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+};
+
+class IPAddress
+{
+private:
+	uint8_t _address[4];
+
+public:
+	IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : _address{ a, b, c, d } { }
+
+	uint8_t operator[](int index) const { return _address[index]; }
+	uint8_t& operator[](int index) { return _address[index]; }
+};
+
+/**
+ * Host console, only written to.
+ */
+class HostSerial : public Stream
+{
+public:
+	size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+	using Print::write;
+	int available() { return 0; }
+	int read() { return -1; }
+	int peek() { return -1; }
+};
+
+extern HostSerial Serial;
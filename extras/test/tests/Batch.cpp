@@ -0,0 +1,83 @@
+#include "Fixture.h"
+#include <algorithm>
+
+#define BATCH_TIMEOUT 5000
+
+TEST(sends_a_batch_as_a_single_line)
+{
+	Bench<> bench;
+
+	// attaching takes a second on its own
+	bench.sim.beginBatch(BATCH_TIMEOUT);
+	CHECK(bench.sim.batchAT("+CGREG=", 1));
+	CHECK(bench.sim.batchAT("+CMEE=", 1));
+	CHECK(bench.sim.batchAT("+CGATT=", 1));
+	CHECK(bench.sim.endBatch());
+
+	CHECK_EQUAL((size_t)1, bench.modem.commands.size());
+	CHECK_EQUAL(std::string("AT+CGREG=1;+CMEE=1;+CGATT=1"), bench.modem.commands[0]);
+	CHECK_EQUAL(1, bench.modem.registrationUrc);
+	CHECK_EQUAL(1, bench.modem.errorReporting);
+	CHECK(bench.modem.attached);
+}
+
+TEST(splits_batches_longer_than_a_command_line)
+{
+	Bench<> bench;
+
+	// the device answers each command of a line in turn, the timeout applying to the whole line
+	bench.sim.beginBatch(BATCH_TIMEOUT);
+	for(int i = 0; i < 100; i++) CHECK(bench.sim.batchAT("+CGREG=", i % 3));
+	CHECK(bench.sim.endBatch());
+
+	CHECK(bench.modem.commands.size() > 1);
+	size_t commands = 0;
+	for(auto& line : bench.modem.commands) {
+		CHECK(line.size() <= SIMCOMAT_MAX_COMMAND_LINE);
+		commands += std::count(line.begin(), line.end(), ';') + 1;
+	}
+
+	CHECK_EQUAL((size_t)100, commands);
+	CHECK_EQUAL(0, bench.modem.registrationUrc);
+}
+
+TEST(stops_at_the_first_failed_line)
+{
+	Bench<> bench;
+	bench.modem.fail("+CMEE");
+
+	bench.sim.beginBatch(BATCH_TIMEOUT);
+	CHECK(bench.sim.batchAT("+CGREG=", 1));
+	CHECK(bench.sim.batchAT("+CMEE=", 1));
+
+	// the first line is sent once full, and fails
+	int queued = 0;
+	while(queued < 100 && bench.sim.batchAT("+CGREG=", 2)) queued++;
+
+	CHECK(queued < 100);
+	CHECK(!bench.sim.endBatch());
+	CHECK_EQUAL((size_t)1, bench.modem.commands.size());
+	// the commands following the failure were not run
+	CHECK_EQUAL(1, bench.modem.registrationUrc);
+}
+
+TEST(ends_a_batch_without_waiting)
+{
+	Bench<> bench;
+
+	bench.sim.beginBatch(BATCH_TIMEOUT);
+	CHECK(bench.sim.batchAT("+CGREG=", 1));
+	CHECK(bench.sim.batchAT("+CGATT=", 1));
+
+	uint32_t start = millis();
+	CHECK(bench.sim.endBatchAsync());
+	CHECK(millis() - start < 5);
+	CHECK(bench.sim.responseStatus() == SIMComATResponseStatus::Pending);
+
+	while(bench.sim.poll() == SIMComATResponseStatus::Pending);
+	CHECK_EQUAL(0, bench.sim.responseResult());
+	CHECK(bench.modem.attached);
+
+	// nothing left to send
+	CHECK(!bench.sim.endBatchAsync());
+}
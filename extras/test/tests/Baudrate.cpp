@@ -0,0 +1,72 @@
+#include "Fixture.h"
+#include <algorithm>
+
+static SIM808Emulator* modem;
+
+static void setHostBaudrate(uint32_t baudrate)
+{
+	modem->setHostBaudrate(baudrate);
+}
+
+/**
+ * A device talking at baudrate, and a host UART at another one.
+ */
+static void wire(Bench<>& bench, uint32_t baudrate)
+{
+	modem = &bench.modem;
+	bench.modem.setBaudrate(baudrate);
+	bench.modem.setHostBaudrate(460800);
+}
+
+TEST(detects_the_baudrate_of_the_device)
+{
+	Bench<> bench;
+	wire(bench, 9600);
+
+	CHECK_EQUAL(9600u, bench.sim.detectBaudrate(setHostBaudrate));
+	CHECK_EQUAL(9600u, bench.modem.hostBaudrate());
+}
+
+TEST(switches_to_the_highest_reliable_baudrate)
+{
+	Bench<> bench;
+	wire(bench, 9600);
+
+	CHECK_EQUAL(115200u, bench.sim.negotiateBaudrate(setHostBaudrate));
+	CHECK_EQUAL(115200u, bench.modem.baudrate());
+	CHECK_EQUAL(115200u, bench.modem.hostBaudrate());
+
+	// the link keeps working
+	CHECK(bench.sim.getSignalQuality().rssi != 99);
+}
+
+TEST(falls_back_when_the_link_is_corrupted)
+{
+	Bench<> bench;
+	wire(bench, 9600);
+	bench.modem.maxReliableBaudrate = 57600;
+
+	CHECK_EQUAL(57600u, bench.sim.negotiateBaudrate(setHostBaudrate, 460800));
+	CHECK_EQUAL(57600u, bench.modem.baudrate());
+	CHECK_EQUAL(57600u, bench.modem.hostBaudrate());
+	CHECK(bench.sim.getSignalQuality().rssi != 99);
+}
+
+TEST(stays_at_the_current_baudrate_when_already_the_highest)
+{
+	Bench<> bench;
+	wire(bench, 115200);
+
+	CHECK_EQUAL(115200u, bench.sim.negotiateBaudrate(setHostBaudrate));
+	CHECK(bench.modem.commands.end() == std::find_if(bench.modem.commands.begin(), bench.modem.commands.end(),
+		[](const std::string& command) { return command.find("+IPR") != std::string::npos; }));
+}
+
+TEST(gives_up_when_the_device_does_not_answer)
+{
+	Bench<> bench;
+	wire(bench, 9600);
+	bench.modem.setPowered(false);
+
+	CHECK_EQUAL(0u, bench.sim.negotiateBaudrate(setHostBaudrate));
+}
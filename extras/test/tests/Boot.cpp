@@ -0,0 +1,67 @@
+#include "Fixture.h"
+
+#define RESET_PULSE 210		///< Time taken by reset() itself, in ms.
+#define FIRST_AT_TIMEOUT SIMCOMAT_DEFAULT_TIMEOUT		///< The first AT sent by init() goes unanswered, the device is not ready yet.
+#define SETTLE_MARGIN 100	///< Time taken by the commands following the boot in init(), in ms.
+
+TEST(returns_as_soon_as_the_phase_is_reached)
+{
+	Bench<> bench;
+
+	uint32_t start = millis();
+	CHECK(bench.sim.init(SIM808BootPhase::Functionality, 5000));
+
+	CHECK(millis() - start >= 600);
+	CHECK(millis() - start < RESET_PULSE + FIRST_AT_TIMEOUT + SETTLE_MARGIN);
+	CHECK(!bench.modem.echo);
+	CHECK_EQUAL(1, bench.modem.errorReporting);
+}
+
+TEST(waits_for_every_phase_whatever_their_order)
+{
+	Bench<> bench;
+	// the SIM is ready before the device is fully functional
+	bench.modem.bootTimings[(uint8_t)SIM808BootPhase::Functionality] = 1200;
+	bench.modem.bootTimings[(uint8_t)SIM808BootPhase::Sim] = 700;
+
+	uint32_t start = millis();
+	CHECK(bench.sim.init(SIM808BootPhase::Sim, 5000));
+	CHECK(millis() - start >= 1200);
+	CHECK(millis() - start < RESET_PULSE + 1200 + SETTLE_MARGIN);
+	CHECK(millis() - start > RESET_PULSE + FIRST_AT_TIMEOUT);
+
+	SIM808BootTimings timings = bench.sim.getBootTimings();
+	CHECK(timings.phases[(uint8_t)SIM808BootPhase::Sim] < timings.phases[(uint8_t)SIM808BootPhase::Functionality]);
+}
+
+TEST(gives_up_after_the_timeout)
+{
+	Bench<> bench;
+	bench.modem.bootTimings[(uint8_t)SIM808BootPhase::Sms] = 60000;
+
+	uint32_t start = millis();
+	CHECK(!bench.sim.init(SIM808BootPhase::Sms, 4000));
+	CHECK(millis() - start >= 4000);
+	CHECK(millis() - start < RESET_PULSE + FIRST_AT_TIMEOUT + 4000 + SETTLE_MARGIN);
+
+	// the device is still usable
+	CHECK(bench.sim.getSignalQuality().rssi != 99);
+}
+
+TEST(powers_on_until_ready_without_status_pin)
+{
+	SIM808Emulator modem;
+	SIM808Probe sim(TEST_RESET_PIN, TEST_PWRKEY_PIN, SIM808_UNAVAILABLE_PIN);
+	modem.attachPins(TEST_RESET_PIN, TEST_PWRKEY_PIN, SIM808_UNAVAILABLE_PIN);
+	sim.begin(modem);
+	modem.setPowered(false);
+
+	uint32_t start = millis();
+	CHECK(sim.powerOnOff(true));
+	CHECK(modem.powered());
+
+	// unanswered AT while off, the key pulse, then RDY, without polling the device with commands
+	uint32_t rdy = sim.getBootTimings().phases[(uint8_t)SIM808BootPhase::Rdy];
+	CHECK(rdy > 0);
+	CHECK(millis() - start < SIMCOMAT_DEFAULT_TIMEOUT + SIM808_PWRKEY_PULSE + 250 + SETTLE_MARGIN);
+}
@@ -0,0 +1,133 @@
+#include "Fixture.h"
+#include <algorithm>
+
+#define MAX_TICKS 100000
+#define MAX_TICK_DURATION 5		///< Longest time a tick may take, in virtual ms.
+
+/**
+ * Tick until the manager reaches state, checking that no tick blocks.
+ * Returns false if it is not reached in MAX_TICKS ticks.
+ */
+static bool tickUntil(SIM808ConnectionManager& connection, SIM808ConnectionState state, uint32_t* longest = NULL)
+{
+	for(uint32_t i = 0; i < MAX_TICKS; i++) {
+		uint32_t start = millis();
+		SIM808ConnectionState current = connection.tick();
+		uint32_t duration = millis() - start;
+
+		if(longest && duration > *longest) *longest = duration;
+		if(current == state) return true;
+	}
+
+	return false;
+}
+
+static bool sent(SIM808Emulator& modem, const std::string& command)
+{
+	return std::find(modem.commands.begin(), modem.commands.end(), command) != modem.commands.end();
+}
+
+TEST(brings_the_bearer_up_without_blocking)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	uint32_t longest = 0;
+
+	connection.begin("internet", "user", "password");
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected, &longest));
+
+	CHECK(longest <= MAX_TICK_DURATION);
+	CHECK(bench.modem.attached);
+	CHECK(bench.modem.bearerOpen);
+	CHECK_EQUAL(std::string("internet"), bench.modem.bearerSettings["APN"]);
+	CHECK_EQUAL(std::string("password"), bench.modem.bearerSettings["PWD"]);
+	CHECK_EQUAL(0, connection.attempts());
+}
+
+TEST(skips_the_steps_already_done)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+
+	connection.begin("internet");
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+
+	CHECK_EQUAL((size_t)2, bench.modem.commands.size());
+	CHECK(sent(bench.modem, "AT+CGREG?"));
+	CHECK(sent(bench.modem, "AT+SAPBR=2,1"));
+}
+
+TEST(reports_connected_only_once_the_device_has_answered)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+
+	connection.begin("internet");
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+	CHECK(bench.sim.responseStatus() != SIMComATResponseStatus::Pending);
+
+	ArduinoShim::advance((uint64_t)SIM808_CONNECTION_CHECK_INTERVAL * 1000000);
+	CHECK(connection.tick() == SIM808ConnectionState::Checking);
+	CHECK(!connection.connected());
+
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+	CHECK(bench.sim.responseStatus() != SIMComATResponseStatus::Pending);
+	CHECK_EQUAL(std::string("AT+SAPBR=2,1"), bench.modem.commands.back());
+}
+
+TEST(starts_over_when_the_bearer_drops)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+
+	connection.begin("internet");
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+
+	bench.modem.bearerOpen = false;
+	ArduinoShim::advance((uint64_t)SIM808_CONNECTION_CHECK_INTERVAL * 1000000);
+	CHECK(tickUntil(connection, SIM808ConnectionState::OpeningBearer));
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+	CHECK(bench.modem.bearerOpen);
+}
+
+TEST(retries_after_a_growing_delay)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	bench.modem.registration = 2;
+
+	connection.begin("internet");
+	uint32_t start = millis();
+
+	while(connection.attempts() < 3) connection.tick();
+	// at least half of 1 s, then 2 s
+	CHECK(millis() - start >= 1500);
+	CHECK(connection.state() == SIM808ConnectionState::Registering);
+
+	bench.modem.registration = 1;
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+	CHECK_EQUAL(0, connection.attempts());
+}
+
+TEST(retries_when_the_bearer_settings_fail)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+	bench.modem.attached = true;
+	bench.modem.fail("+SAPBR=3", 1);
+
+	connection.begin("internet");
+	for(uint32_t i = 0; i < MAX_TICKS && !connection.attempts(); i++) connection.tick();
+	CHECK_EQUAL(1, connection.attempts());
+	CHECK(!bench.modem.bearerOpen);
+
+	CHECK(tickUntil(connection, SIM808ConnectionState::Connected));
+	CHECK_EQUAL(0, connection.attempts());
+	CHECK(bench.modem.bearerOpen);
+}
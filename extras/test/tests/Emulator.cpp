@@ -0,0 +1,100 @@
+#include "Fixture.h"
+
+TEST(answers_after_its_latency)
+{
+	Bench<> bench;
+	bench.modem.setDefaultLatency(50);
+
+	uint32_t start = millis();
+	bench.sim.sendAT();
+
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+	CHECK(millis() - start >= 50);
+	CHECK(millis() - start < 60);
+	CHECK_EQUAL(std::string("AT"), bench.modem.commands.back());
+}
+
+TEST(paces_responses_at_the_baudrate)
+{
+	Bench<> bench;
+	bench.modem.setDefaultLatency(0);
+	bench.modem.setBaudrate(1200);
+	bench.modem.setHostBaudrate(1200);
+	bench.modem.respond("+GMR", "\r\n" + std::string(118, 'x') + "\r\n\r\nOK\r\n");
+
+	uint32_t start = millis();
+	bench.sim.sendAT("+GMR");
+
+	// 128 bytes of 10 bits
+	CHECK_EQUAL(0, bench.sim.waitResponse(2000));
+	CHECK(millis() - start >= 1066);
+	CHECK(millis() - start < 1200);
+}
+
+TEST(runs_batched_commands_until_the_first_failure)
+{
+	Bench<> bench;
+
+	bench.sim.beginBatch();
+	bench.sim.batchAT("+CGREG=", 1);
+	bench.sim.batchAT("+UNKNOWN");
+	bench.sim.batchAT("+CGREG=", 2);
+
+	CHECK(!bench.sim.endBatch());
+	CHECK_EQUAL((size_t)1, bench.modem.commands.size());
+	CHECK_EQUAL(1, bench.modem.registrationUrc);
+}
+
+TEST(injects_failures)
+{
+	Bench<> bench;
+	bench.modem.errorReporting = 1;
+	bench.modem.fail("+CSQ", 1, 30);
+
+	CHECK_EQUAL(99, bench.sim.getSignalQuality().rssi);
+	CHECK_EQUAL(30, bench.sim.errorCode());
+}
+
+TEST(ignores_commands_sent_at_another_baudrate)
+{
+	Bench<> bench;
+	bench.modem.setHostBaudrate(9600);
+
+	bench.sim.sendAT();
+	CHECK_EQUAL(-1, bench.sim.waitResponse(500));
+}
+
+TEST(locks_on_the_first_command_when_autobauding)
+{
+	Bench<> bench;
+	bench.modem.setBaudrate(0);
+	bench.modem.setHostBaudrate(57600);
+
+	bench.sim.sendAT();
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+	CHECK_EQUAL(57600u, bench.modem.baudrate());
+}
+
+TEST(boots_again_on_reset)
+{
+	Bench<> bench;
+
+	CHECK(bench.sim.init(SIM808BootPhase::Sms, 5000));
+	SIM808BootTimings timings = bench.sim.getBootTimings();
+
+	// each line takes a little less than 1 ms to be received
+	CHECK(timings.phases[(uint8_t)SIM808BootPhase::Rdy] - 250 <= 1);
+	CHECK(timings.phases[(uint8_t)SIM808BootPhase::Sms] - 3000 <= 1);
+	CHECK(!bench.modem.echo);
+}
+
+TEST(toggles_power_with_the_power_key)
+{
+	Bench<> bench;
+
+	CHECK(bench.sim.powered());
+	CHECK(bench.sim.powerOnOff(false));
+	CHECK(!bench.modem.powered());
+	CHECK(bench.sim.powerOnOff(true));
+	CHECK(bench.modem.powered());
+}
@@ -0,0 +1,66 @@
+#include "Fixture.h"
+
+#define LONG_TIMEOUT 10000
+
+TEST(fails_right_away_on_a_cme_error)
+{
+	Bench<> bench;
+	bench.modem.errorReporting = 1;
+	bench.modem.fail("+CSQ", 1, 30);
+
+	uint32_t start = millis();
+	bench.sim.sendAT("+CSQ");
+
+	CHECK_EQUAL(SIMCOMAT_RESULT_FAILED, bench.sim.waitResponse(LONG_TIMEOUT, TO_F("+CSQ")));
+	CHECK(millis() - start < 100);
+	CHECK_EQUAL(30, bench.sim.errorCode());
+}
+
+TEST(fails_right_away_on_error_when_awaiting_something_else)
+{
+	Bench<> bench;
+	bench.modem.fail("+CSQ");
+
+	uint32_t start = millis();
+	bench.sim.sendAT("+CSQ");
+
+	// ERROR is not awaited
+
+	CHECK_EQUAL(SIMCOMAT_RESULT_FAILED, bench.sim.waitResponse(LONG_TIMEOUT, TO_F("+CSQ"), NULL));
+	CHECK(millis() - start < 100);
+	CHECK_EQUAL(-1, bench.sim.errorCode());
+}
+
+TEST(fails_right_away_on_other_final_result_codes)
+{
+	Bench<> bench;
+	bench.modem.respond("+CIPSEND", "\r\nSEND FAIL\r\n");
+
+	uint32_t start = millis();
+	bench.sim.sendAT("+CIPSEND");
+
+	CHECK_EQUAL(SIMCOMAT_RESULT_FAILED, bench.sim.waitResponse(LONG_TIMEOUT, TO_F("SEND OK"), NULL));
+	CHECK(millis() - start < 100);
+}
+
+TEST(matches_awaited_errors_as_tokens)
+{
+	Bench<> bench;
+	bench.modem.fail("+CSQ");
+
+	bench.sim.sendAT("+CSQ");
+	CHECK_EQUAL(1, bench.sim.waitResponse());
+}
+
+TEST(forgets_the_error_code_of_the_previous_response)
+{
+	Bench<> bench;
+	bench.modem.errorReporting = 1;
+	bench.modem.fail("+CSQ", 1, 30);
+
+	CHECK_EQUAL(99, bench.sim.getSignalQuality().rssi);
+	CHECK_EQUAL(30, bench.sim.errorCode());
+
+	CHECK(bench.sim.getSignalQuality().rssi != 99);
+	CHECK_EQUAL(-1, bench.sim.errorCode());
+}
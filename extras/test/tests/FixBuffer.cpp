@@ -0,0 +1,102 @@
+#include "Fixture.h"
+#include "SIM808.FixBuffer.h"
+
+static SIM808GnssFix makeFix(uint32_t i)
+{
+	SIM808GnssFix fix;
+	memset(&fix, 0, sizeof(fix));
+
+	// crossing midnight, the end of february of a leap year and the end of the year
+	uint32_t dates[][3] = { { 2024, 2, 28 }, { 2024, 2, 29 }, { 2024, 3, 1 }, { 2024, 12, 31 }, { 2025, 1, 1 } };
+	uint32_t* date = dates[(i / 3) % 5];
+
+	fix.runStatus = 1;
+	fix.fixStatus = i % 7 ? 1 : 0;
+	fix.year = date[0];
+	fix.month = date[1];
+	fix.day = date[2];
+	fix.hour = 23;
+	fix.minute = 59;
+	fix.second = 57 + i % 3;
+	fix.latitude = -33868820 + (int32_t)i * 11;
+	fix.longitude = 151209290 - (int32_t)i * 7;
+	fix.altitude = 5820 + (int32_t)(i % 4);
+	fix.speed = 1200 + i;
+	fix.course = 27000 + i % 100;
+	fix.hdop = 90;
+	fix.gnssUsed = 9;
+	return fix;
+}
+
+static bool sameKeptFields(const SIM808GnssFix& a, const SIM808GnssFix& b)
+{
+	return a.runStatus == b.runStatus && a.fixStatus == b.fixStatus &&
+		a.year == b.year && a.month == b.month && a.day == b.day &&
+		a.hour == b.hour && a.minute == b.minute && a.second == b.second &&
+		a.latitude == b.latitude && a.longitude == b.longitude && a.altitude == b.altitude &&
+		a.speed == b.speed && a.course == b.course && a.hdop == b.hdop && a.gnssUsed == b.gnssUsed;
+}
+
+TEST(decodes_what_was_encoded)
+{
+	SIM808FixEncoder encoder;
+	SIM808FixDecoder decoder;
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808GnssFix decoded;
+
+	for(uint32_t i = 0; i < 30; i++) {
+		SIM808GnssFix fix = makeFix(i);
+		uint8_t length = encoder.encode(fix, record);
+
+		CHECK(length <= SIM808_FIX_MAX_RECORD_SIZE);
+		// only keyframes hold the values themselves
+		if(i) CHECK(length <= 14);
+
+		CHECK_EQUAL(length, decoder.decode(record, length, &decoded));
+		CHECK(sameKeptFields(fix, decoded));
+	}
+}
+
+TEST(rejects_truncated_records)
+{
+	SIM808FixEncoder encoder;
+	SIM808FixDecoder decoder;
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808GnssFix decoded;
+
+	uint8_t length = encoder.encode(makeFix(0), record);
+	for(uint8_t size = 0; size < length; size++) CHECK_EQUAL(0, decoder.decode(record, size, &decoded));
+}
+
+TEST(splits_fixes_into_frames_decoded_on_their_own)
+{
+	SIM808StaticFixRing<1024> ring;
+	uint8_t frame[64];
+	uint32_t pushed = 0, decoded = 0;
+	size_t frameSize;
+
+	while(pushed < 40 && ring.push(makeFix(pushed))) pushed++;
+	CHECK_EQUAL((uint32_t)40, pushed);
+
+	// too small for a single fix
+	CHECK_EQUAL((size_t)0, ring.popFrame(frame, 8));
+
+	while((frameSize = ring.popFrame(frame, sizeof(frame))) != 0) {
+		SIM808FixDecoder decoder;
+		SIM808GnssFix fix;
+		size_t offset = 1;
+
+		CHECK_EQUAL(SIM808_FIX_FRAME_VERSION, frame[0]);
+		while(offset < frameSize) {
+			uint8_t length = decoder.decode(frame + offset, frameSize - offset, &fix);
+			CHECK(length != 0);
+			CHECK(sameKeptFields(makeFix(decoded), fix));
+
+			offset += length;
+			decoded++;
+		}
+	}
+
+	CHECK_EQUAL(pushed, decoded);
+	CHECK(ring.empty());
+}
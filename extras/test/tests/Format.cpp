@@ -0,0 +1,81 @@
+#include "Fixture.h"
+#include <cstring>
+
+AT_COMMAND_SPEC(FORMAT_TEST, "+FMT=", NULL, 1000);
+TOKEN_TEXT(SLOW, "+SLOW");
+AT_COMMAND_SPEC(SLOW_TEST, "+SLOW", TOKEN_SLOW, 3000);
+
+const char FLASH_TEXT[] S_PROGMEM = "flash";
+
+static std::string sentLine(Bench<>& bench)
+{
+	bench.sim.waitResponse(100);
+	return bench.modem.commands.back();
+}
+
+TEST(formats_every_conversion)
+{
+	Bench<> bench;
+
+	bench.sim.sendFormatAT(TO_F("+FMT=%d,%d,%l,%l,\"%s\",\"%S\",100%%"), 0, -42, 2147483647L, -2147483647L - 1, "ram", TO_F(FLASH_TEXT));
+	CHECK_EQUAL(std::string("AT+FMT=0,-42,2147483647,-2147483648,\"ram\",\"flash\",100%"), sentLine(bench));
+}
+
+TEST(formats_lines_longer_than_the_line_buffer)
+{
+	Bench<> bench;
+	std::string value(3 * SIMCOMAT_LINE_BUFFER_SIZE + 5, 'v');
+
+	bench.sim.sendFormatAT(TO_F("+FMT=\"%s\",%d"), value.c_str(), 7);
+	CHECK_EQUAL("AT+FMT=\"" + value + "\",7", sentLine(bench));
+}
+
+TEST(stops_at_a_trailing_percent)
+{
+	Bench<> bench;
+
+	bench.sim.sendFormatAT(TO_F("+FMT=1%"));
+	CHECK_EQUAL(std::string("AT+FMT=1"), sentLine(bench));
+}
+
+TEST(writes_command_parameters_comma_separated)
+{
+	Bench<> bench;
+	bench.modem.clearObservations();
+
+	bench.sim.sendCommandAT(AT_FORMAT_TEST, (uint8_t)1, "quoted", (int16_t)-3, (uint32_t)4000000000UL);
+	CHECK_EQUAL(std::string("AT+FMT=1,\"quoted\",-3,4000000000"), sentLine(bench));
+	// assembled first, then written at once
+	CHECK_EQUAL((uint32_t)1, bench.modem.writeCalls);
+}
+
+TEST(waits_with_the_command_own_timeout)
+{
+	Bench<> bench;
+	bench.modem.respond("+SLOW", "\r\n+SLOW: 1\r\n\r\nOK\r\n");
+	bench.modem.setLatency("+SLOW", 2000);
+
+	uint32_t start = millis();
+	bench.sim.sendCommandAT(AT_SLOW_TEST);
+	CHECK_EQUAL(0, bench.sim.waitResponse(AT_SLOW_TEST));
+	CHECK(millis() - start >= 2000);
+	CHECK_EQUAL(0, strncmp(bench.sim.replyBuffer, "+SLOW: 1", 8));
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+
+	// the same delay exceeds the timeout of another command
+	bench.modem.respond("+FMT", "\r\nOK\r\n");
+	bench.modem.setLatency("+FMT", 2000);
+	start = millis();
+	bench.sim.sendCommandAT(AT_FORMAT_TEST, 1);
+	CHECK_EQUAL(-1, bench.sim.waitResponse(AT_FORMAT_TEST));
+	CHECK(millis() - start < 1100);
+}
+
+TEST(gives_slow_device_commands_a_longer_timeout)
+{
+	Bench<> bench;
+	bench.modem.setLatency("+CFUN=", 5000);
+
+	CHECK(bench.sim.setPhoneFunctionality(SIM808PhoneFunctionality::Minimum));
+	CHECK_EQUAL(0, bench.modem.functionality);
+}
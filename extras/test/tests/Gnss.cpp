@@ -0,0 +1,103 @@
+#include "Fixture.h"
+
+TEST(parses_every_field_of_a_sequence)
+{
+	SIM808GnssFix fix;
+
+	CHECK(SIM808::parseGpsFix("1,1,20190325161342.500,48.858370,-2.294481,35.300,1.25,90.5,1,,0.9,1.2,0.8,,12,9,3,,42,1.5,2\r\n", &fix));
+
+	CHECK_EQUAL(1, fix.runStatus);
+	CHECK_EQUAL(1, fix.fixStatus);
+	CHECK_EQUAL(2019, fix.year);
+	CHECK_EQUAL(3, fix.month);
+	CHECK_EQUAL(25, fix.day);
+	CHECK_EQUAL(16, fix.hour);
+	CHECK_EQUAL(13, fix.minute);
+	CHECK_EQUAL(42, fix.second);
+	CHECK_EQUAL(500, fix.millisecond);
+	CHECK_EQUAL(48858370, fix.latitude);
+	CHECK_EQUAL(-2294481, fix.longitude);
+	CHECK_EQUAL(3530, fix.altitude);
+	CHECK_EQUAL((uint32_t)1250, fix.speed);
+	CHECK_EQUAL(9050, fix.course);
+	CHECK_EQUAL(1, fix.fixMode);
+	CHECK_EQUAL(90, fix.hdop);
+	CHECK_EQUAL(120, fix.pdop);
+	CHECK_EQUAL(80, fix.vdop);
+	// fields 14 to 16 : GPS satellites in view, GNSS satellites used, GLONASS satellites in view
+	CHECK_EQUAL(12, fix.gpsInView);
+	CHECK_EQUAL(9, fix.gnssUsed);
+	CHECK_EQUAL(3, fix.glonassInView);
+	CHECK_EQUAL(42, fix.cn0Max);
+	CHECK_EQUAL((uint32_t)150, fix.hpa);
+	CHECK_EQUAL((uint32_t)200, fix.vpa);
+}
+
+TEST(reads_the_fix_of_the_device)
+{
+	Bench<> bench;
+	SIM808GnssFix fix;
+
+	bench.modem.gnssPower = true;
+	CHECK(bench.sim.getGpsFix(&fix, 8) == SIM808GpsStatus::AccurateFix);
+
+	CHECK_EQUAL(48858370, fix.latitude);
+	CHECK_EQUAL(12, fix.gpsInView);
+	CHECK_EQUAL(9, fix.gnssUsed);
+	CHECK_EQUAL(3, fix.glonassInView);
+}
+
+static uint32_t streamed;
+static SIM808GnssFix lastStreamed;
+
+static void receiveFix(const SIM808GnssFix& fix)
+{
+	lastStreamed = fix;
+	streamed++;
+}
+
+static void pollFor(SIM808Probe& sim, uint32_t ms)
+{
+	uint32_t start = millis();
+	while(millis() - start < ms) sim.poll();
+}
+
+TEST(streams_the_fixes_pushed_by_the_device)
+{
+	Bench<> bench;
+	SIM808GnssStream stream(receiveFix);
+	streamed = 0;
+
+	CHECK(bench.sim.startGpsStream(stream, 1));
+	CHECK(bench.modem.gnssPower);
+	bench.modem.clearObservations();
+
+	pollFor(bench.sim, 3500);
+	CHECK_EQUAL((uint32_t)3, streamed);
+	CHECK_EQUAL(48858370, lastStreamed.latitude);
+	CHECK_EQUAL(9, lastStreamed.gnssUsed);
+	// nothing polled the device
+	CHECK(bench.modem.commands.empty());
+
+	CHECK(bench.sim.stopGpsStream());
+	pollFor(bench.sim, 3000);
+	CHECK_EQUAL((uint32_t)3, streamed);
+}
+
+TEST(streams_fixes_while_waiting_for_a_response)
+{
+	Bench<> bench;
+	SIM808GnssStream stream(receiveFix);
+	char response[16];
+	streamed = 0;
+
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+	CHECK(bench.sim.startGpsStream(stream, 1));
+
+	// fixes are pushed while the request result is awaited
+	bench.modem.setLatency("+HTTPACTION:", 2500);
+	CHECK_EQUAL(200, bench.sim.httpGet("http://example.com/", response, sizeof(response)));
+	CHECK(streamed >= 2);
+	CHECK_EQUAL(3, lastStreamed.glonassInView);
+}
@@ -0,0 +1,25 @@
+#include "Fixture.h"
+
+TEST(reads_the_imei_into_an_exact_buffer)
+{
+	Bench<> bench;
+	char imei[16];
+
+	bench.modem.imei = "861234567890123";
+
+	CHECK_EQUAL((size_t)15, bench.sim.getImei(imei, sizeof(imei)));
+	CHECK_EQUAL("861234567890123", imei);
+}
+
+TEST(truncates_the_imei_into_a_short_buffer)
+{
+	Bench<> bench;
+	char imei[8] = { 0 };
+	char guard[8] = "guard";
+
+	bench.modem.imei = "861234567890123";
+
+	CHECK_EQUAL((size_t)7, bench.sim.getImei(imei, sizeof(imei)));
+	CHECK_EQUAL("8612345", imei);
+	CHECK_EQUAL("guard", guard);
+}
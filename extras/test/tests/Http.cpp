@@ -0,0 +1,245 @@
+#include "Fixture.h"
+
+#define LARGE_RESPONSE_SIZE (3 * 1024 * 1024UL)	///< Several megabytes, past any 16 bits size or offset.
+
+/**
+ * Get a boolean indicating wether or not a line sent since the last clearObservations() holds text.
+ */
+static bool sent(SIM808Emulator& modem, const std::string& text)
+{
+	for(auto& command : modem.commands) {
+		if(command.find(text) != std::string::npos) return true;
+	}
+
+	return false;
+}
+
+static void connect(SIM808Emulator& modem)
+{
+	modem.attached = true;
+	modem.bearerOpen = true;
+}
+
+TEST(sets_every_parameter_up_for_a_request)
+{
+	Bench<> bench;
+	char response[16];
+	connect(bench.modem);
+
+	CHECK_EQUAL(200, bench.sim.httpPost("https://example.com/", "text/plain", "body", response, sizeof(response)));
+	CHECK(sent(bench.modem, "+HTTPINIT"));
+	CHECK(sent(bench.modem, "+HTTPSSL=1"));
+
+	CHECK_EQUAL((size_t)1, bench.modem.httpRequests.size());
+	CHECK_EQUAL(std::string("https://example.com/"), bench.modem.httpRequests[0].url);
+	CHECK_EQUAL(std::string("text/plain"), bench.modem.httpRequests[0].contentType);
+	CHECK_EQUAL(std::string("body"), bench.modem.httpRequests[0].body);
+	CHECK(bench.modem.httpRequests[0].ssl);
+}
+
+TEST(sends_only_the_parameters_changed_in_a_session)
+{
+	Bench<> bench;
+	SIM808HttpSession session(bench.sim);
+	char response[16];
+	connect(bench.modem);
+
+	CHECK_EQUAL(200, session.get("http://example.com/", response, sizeof(response)));
+	CHECK(sent(bench.modem, "+HTTPINIT"));
+	CHECK(!sent(bench.modem, "+HTTPSSL"));
+
+	bench.modem.clearObservations();
+	CHECK_EQUAL(200, session.get("http://example.com/", response, sizeof(response)));
+	CHECK(!sent(bench.modem, "+HTTPINIT"));
+	CHECK(!sent(bench.modem, "+HTTPPARA"));
+
+	bench.modem.clearObservations();
+	CHECK_EQUAL(200, session.get("https://example.com/", response, sizeof(response)));
+	CHECK(sent(bench.modem, "\"URL\",\"https://example.com/\""));
+	CHECK(sent(bench.modem, "+HTTPSSL=1"));
+	CHECK(!sent(bench.modem, "+HTTPINIT"));
+
+	bench.modem.clearObservations();
+	CHECK_EQUAL(200, session.post("https://example.com/", "text/plain", "body", response, sizeof(response)));
+	CHECK(sent(bench.modem, "\"CONTENT\",\"text/plain\""));
+	CHECK(!sent(bench.modem, "\"URL\""));
+	CHECK(!sent(bench.modem, "+HTTPSSL"));
+
+	CHECK_EQUAL((size_t)4, bench.modem.httpRequests.size());
+	CHECK(bench.modem.httpRequests[3].ssl);
+}
+
+TEST(compares_the_session_url_to_the_previous_one)
+{
+	Bench<> bench;
+	SIM808HttpSession session(bench.sim);
+	char response[16];
+	char url[32] = "http://example.com/kxfrw";
+	std::string longUrl = "http://example.com/" + std::string(SIM808_HTTP_SESSION_URL_SIZE, 'l');
+	connect(bench.modem);
+
+	CHECK_EQUAL(200, session.get(url, response, sizeof(response)));
+
+	// same buffer, same length, and same 32 bits FNV-1a hash
+	strcpy(url, "http://example.com/qkexa");
+	bench.modem.clearObservations();
+	CHECK_EQUAL(200, session.get(url, response, sizeof(response)));
+	CHECK(sent(bench.modem, "\"URL\",\"http://example.com/qkexa\""));
+	CHECK_EQUAL(std::string("http://example.com/qkexa"), bench.modem.httpRequests.back().url);
+
+	// too long to be remembered, sent each time
+	for(int i = 0; i < 2; i++) {
+		bench.modem.clearObservations();
+		CHECK_EQUAL(200, session.get(longUrl.c_str(), response, sizeof(response)));
+		CHECK(sent(bench.modem, "\"URL\""));
+	}
+	CHECK_EQUAL(longUrl, bench.modem.httpRequests.back().url);
+}
+
+TEST(starts_a_session_over_after_a_one_shot_request)
+{
+	Bench<> bench;
+	SIM808HttpSession session(bench.sim);
+	char response[16];
+	connect(bench.modem);
+
+	CHECK_EQUAL(200, session.get("https://example.com/", response, sizeof(response)));
+	CHECK_EQUAL(200, bench.sim.httpGet("http://example.com/other", response, sizeof(response)));
+
+	bench.modem.clearObservations();
+	CHECK_EQUAL(200, session.get("https://example.com/", response, sizeof(response)));
+	CHECK(sent(bench.modem, "+HTTPINIT"));
+	CHECK(sent(bench.modem, "+HTTPSSL=1"));
+	CHECK_EQUAL(std::string("https://example.com/"), bench.modem.httpRequests.back().url);
+	CHECK(bench.modem.httpRequests.back().ssl);
+}
+
+static size_t countSent(SIM808Emulator& modem, const std::string& text)
+{
+	size_t count = 0;
+
+	for(auto& command : modem.commands) {
+		if(command.find(text) != std::string::npos) count++;
+	}
+
+	return count;
+}
+
+TEST(streams_responses_larger_than_the_reply_buffer)
+{
+	Bench<> bench;
+	MemoryStream output;
+	SIM808HttpTransferReport report;
+	std::string body;
+	connect(bench.modem);
+
+	// every byte value, and lines looking like result codes, must go through untouched
+	for(uint32_t i = 0; i < LARGE_RESPONSE_SIZE; i++) body += (char)(i * 31 + (i >> 16));
+	body.replace(1000, 6, "\r\nOK\r\n");
+	body.replace(2000, 9, "\r\nERROR\r\n");
+	body.replace(LARGE_RESPONSE_SIZE - 100, 17, "\r\n+HTTPREAD: 64\r\n");
+	bench.modem.setHttpServer([&](const EmulatorHttpRequest& request, std::string& response) {
+		response = body;
+		return (uint16_t)200;
+	});
+
+	CHECK_EQUAL(200, bench.sim.httpGet("http://example.com/", output, &report));
+	CHECK_EQUAL(body.size(), output.output.size());
+	CHECK(output.output == body);
+	CHECK_EQUAL((uint32_t)LARGE_RESPONSE_SIZE, report.size);
+	CHECK_EQUAL((uint32_t)LARGE_RESPONSE_SIZE, report.transferred);
+	CHECK_EQUAL((size_t)(LARGE_RESPONSE_SIZE + HTTP_READ_CHUNK_SIZE - 1) / HTTP_READ_CHUNK_SIZE, countSent(bench.modem, "+HTTPREAD"));
+}
+
+TEST(streams_empty_responses)
+{
+	Bench<> bench;
+	MemoryStream output;
+	SIM808HttpTransferReport report;
+	connect(bench.modem);
+
+	bench.modem.setHttpServer([](const EmulatorHttpRequest& request, std::string& response) {
+		response.clear();
+		return (uint16_t)204;
+	});
+
+	CHECK_EQUAL(204, bench.sim.httpGet("http://example.com/", output, &report));
+	CHECK(output.output.empty());
+	CHECK_EQUAL((uint32_t)0, report.transferred);
+}
+
+static uint32_t produced;
+
+static size_t produceBody(uint8_t* buffer, size_t size, uint32_t offset)
+{
+	for(size_t i = 0; i < size; i++) buffer[i] = (uint8_t)((offset + i) * 7);
+
+	produced += size;
+	return size;
+}
+
+static size_t abortBody(uint8_t* buffer, size_t size, uint32_t offset)
+{
+	return offset < 1000 ? produceBody(buffer, size, offset) : 0;
+}
+
+TEST(posts_bodies_read_from_a_stream)
+{
+	Bench<> bench;
+	char response[16];
+	std::string body;
+	connect(bench.modem);
+
+	for(int i = 0; i < 4096; i++) body += (char)(i * 13);
+	MemoryStream input(body);
+
+	CHECK_EQUAL(200, bench.sim.httpPost("http://example.com/", TO_F("application/octet-stream"), input, 4096, response, sizeof(response)));
+	CHECK_EQUAL((size_t)1, bench.modem.httpRequests.size());
+	CHECK(bench.modem.httpRequests[0].body == body);
+	CHECK_EQUAL(std::string("application/octet-stream"), bench.modem.httpRequests[0].contentType);
+}
+
+TEST(posts_bodies_pulled_from_a_producer)
+{
+	Bench<> bench;
+	char response[16];
+	std::string body;
+	connect(bench.modem);
+	produced = 0;
+
+	for(int i = 0; i < 3000; i++) body += (char)(i * 7);
+
+	CHECK_EQUAL(200, bench.sim.httpPost("http://example.com/", TO_F("text/plain"), produceBody, 3000, response, sizeof(response)));
+	CHECK_EQUAL((uint32_t)3000, produced);
+	CHECK(bench.modem.httpRequests[0].body == body);
+}
+
+TEST(aborts_when_the_producer_gives_up)
+{
+	Bench<> bench;
+	char response[16];
+	connect(bench.modem);
+
+	CHECK(bench.sim.httpPost("http://example.com/", TO_F("text/plain"), abortBody, 3000, response, sizeof(response)) != 200);
+	CHECK(bench.modem.httpRequests.empty());
+
+	// the device is usable again right away
+	CHECK_EQUAL(200, bench.sim.httpPost("http://example.com/", "text/plain", "body", response, sizeof(response)));
+	CHECK_EQUAL(std::string("body"), bench.modem.httpRequests[0].body);
+}
+
+TEST(aborts_when_the_body_stream_runs_dry)
+{
+	Bench<> bench;
+	char response[16];
+	MemoryStream input(std::string(1000, 'b'));
+	connect(bench.modem);
+
+	uint32_t start = millis();
+	CHECK(bench.sim.httpPost("http://example.com/", TO_F("text/plain"), input, 3000, response, sizeof(response)) != 200);
+	CHECK(bench.modem.httpRequests.empty());
+
+	CHECK_EQUAL(200, bench.sim.httpPost("http://example.com/", "text/plain", "body", response, sizeof(response)));
+	CHECK(millis() - start < HTTP_BODY_TIMEOUT);
+	CHECK_EQUAL(std::string("body"), bench.modem.httpRequests[0].body);
+}
@@ -0,0 +1,79 @@
+#include "Fixture.h"
+
+#define NO_FIX "1,0,20190325161342.000,,,,0.00,0.0,0,,,,,,5,0,0,,,,"
+
+static size_t countSent(SIM808Emulator& modem, const std::string& text)
+{
+	size_t count = 0;
+
+	for(auto& command : modem.commands) {
+		if(command.find(text) != std::string::npos) count++;
+	}
+
+	return count;
+}
+
+TEST(reads_the_location_of_the_cell)
+{
+	Bench<> bench;
+	SIM808GnssFix fix;
+	bench.modem.bearerOpen = true;
+	bench.modem.cellLocation = "-122.419416,37.774929,2019/03/25,16:13:40";
+
+	CHECK(bench.sim.getCellLocation(&fix));
+	CHECK_EQUAL(-122419416, fix.longitude);
+	CHECK_EQUAL(37774929, fix.latitude);
+	CHECK_EQUAL(2019, fix.year);
+	CHECK_EQUAL(3, fix.month);
+	CHECK_EQUAL(25, fix.day);
+	CHECK_EQUAL(16, fix.hour);
+	CHECK_EQUAL(13, fix.minute);
+	CHECK_EQUAL(40, fix.second);
+	CHECK_EQUAL(0, fix.fixStatus);
+}
+
+TEST(fails_to_locate_the_cell_without_bearer)
+{
+	Bench<> bench;
+	SIM808GnssFix fix;
+
+	CHECK(!bench.sim.getCellLocation(&fix));
+}
+
+TEST(upgrades_the_cell_location_to_a_gps_fix)
+{
+	Bench<> bench;
+	SIM808Locator locator(bench.sim);
+	bench.modem.bearerOpen = true;
+	bench.modem.gnssFix = NO_FIX;
+
+	CHECK(locator.begin() == SIM808LocationSource::Cell);
+	CHECK(bench.modem.gnssPower);
+	CHECK_EQUAL(48858260, locator.location().latitude);
+
+	// the network is asked only once
+	CHECK(locator.update() == SIM808LocationSource::Cell);
+	CHECK_EQUAL((size_t)1, countSent(bench.modem, "+CIPGSMLOC"));
+
+	bench.modem.gnssFix = "1,1,20190325161342.000,48.858370,2.294481,35.300,0.00,0.0,1,,0.9,1.2,0.8,,12,9,3,,42,,";
+	CHECK(locator.update() == SIM808LocationSource::AccurateGnss);
+	CHECK_EQUAL(48858370, locator.location().latitude);
+
+	// the fix is kept once lost
+	bench.modem.gnssFix = NO_FIX;
+	CHECK(locator.update() == SIM808LocationSource::AccurateGnss);
+	CHECK_EQUAL(48858370, locator.location().latitude);
+	CHECK_EQUAL((size_t)1, countSent(bench.modem, "+CIPGSMLOC"));
+}
+
+TEST(asks_the_network_again_until_it_answers)
+{
+	Bench<> bench;
+	SIM808Locator locator(bench.sim);
+	bench.modem.gnssFix = NO_FIX;
+
+	CHECK(locator.begin() == SIM808LocationSource::None);
+
+	bench.modem.bearerOpen = true;
+	CHECK(locator.update() == SIM808LocationSource::Cell);
+}
@@ -0,0 +1,156 @@
+#include "Fixture.h"
+#include <chrono>
+#include <random>
+
+#define FUZZ_ITERATIONS 20000
+#define BENCHMARK_ITERATIONS 200000
+
+static void setReply(SIM808Probe& sim, const std::string& reply)
+{
+	strlcpy(sim.replyBuffer, reply.c_str(), sim.replyBufferSize);
+}
+
+template<typename T> static std::string randomField(std::mt19937& random, T* value)
+{
+	std::uniform_int_distribution<long> distribution(std::numeric_limits<T>::min(), std::numeric_limits<T>::max());
+	*value = (T)distribution(random);
+
+	return std::string(random() % 2, ' ') + std::to_string((long)*value);
+}
+
+TEST(matches_the_indexed_parsers_on_random_replies)
+{
+	Bench<> bench;
+	std::mt19937 random(808);
+
+	for(uint32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+		uint8_t u8, fu8, pu8;
+		int8_t s8, fs8, ps8;
+		uint16_t u16, fu16, pu16;
+		int16_t s16, fs16, ps16;
+
+		std::string reply = "+TEST:" +
+			randomField(random, &u8) + "," +
+			randomField(random, &s8) + "," +
+			randomField(random, &u16) + "," +
+			randomField(random, &s16) + (random() % 2 ? "\r\n" : "");
+		setReply(bench.sim, reply);
+
+		CHECK(bench.sim.parseReplyFields(',', &fu8, &fs8, &fu16, &fs16));
+		CHECK(bench.sim.parse(bench.sim.replyBuffer, ',', 0, &pu8));
+		CHECK(bench.sim.parse(bench.sim.replyBuffer, ',', 1, &ps8));
+		CHECK(bench.sim.parse(bench.sim.replyBuffer, ',', 2, &pu16));
+		CHECK(bench.sim.parse(bench.sim.replyBuffer, ',', 3, &ps16));
+
+		CHECK_EQUAL(u8, fu8);
+		CHECK_EQUAL(pu8, fu8);
+		CHECK_EQUAL(ps8, fs8);
+		CHECK_EQUAL(pu16, fu16);
+		CHECK_EQUAL(ps16, fs16);
+	}
+}
+
+TEST(reads_the_last_field_up_to_the_line_ending)
+{
+	Bench<> bench;
+	uint8_t quality, errorRate;
+
+	setReply(bench.sim, "+CSQ: 21,0\r\n");
+	CHECK(bench.sim.parseReplyFields(',', &quality, &errorRate));
+	CHECK_EQUAL(21, quality);
+	CHECK_EQUAL(0, errorRate);
+}
+
+TEST(skips_null_results)
+{
+	Bench<> bench;
+	uint16_t statusCode;
+	uint32_t dataSize;
+
+	setReply(bench.sim, "+HTTPACTION: 0,200,1024\r\n");
+	CHECK(bench.sim.parseReplyFields(',', (uint8_t*)NULL, &statusCode, &dataSize));
+	CHECK_EQUAL(200, statusCode);
+	CHECK_EQUAL(1024u, dataSize);
+}
+
+TEST(rejects_malformed_fields)
+{
+	Bench<> bench;
+	uint8_t a, b;
+
+	const char* replies[] = {
+		"+TEST: 1\r\n",			// missing field
+		"+TEST: 1,\r\n",		// empty field
+		"+TEST: 1,x\r\n",		// not a number
+		"+TEST: 1,2x\r\n",		// trailing garbage
+		"+TEST: 1,256\r\n",		// out of range
+		"+TEST: -1,2\r\n",		// negative unsigned
+		"+TEST: 1,99999999999\r\n",	// out of 32 bits
+	};
+
+	for(const char* reply : replies) {
+		setReply(bench.sim, reply);
+		CHECK(!bench.sim.parseReplyFields(',', &a, &b));
+	}
+}
+
+TEST(parses_the_replies_of_the_device)
+{
+	Bench<> bench;
+	bench.modem.rssi = 17;
+	bench.modem.ber = 3;
+	bench.modem.chargeState = 1;
+	bench.modem.chargeLevel = 64;
+	bench.modem.voltage = 3900;
+	bench.modem.attached = true;
+	bench.modem.bearerOpen = true;
+
+	SIM808SignalQualityReport report = bench.sim.getSignalQuality();
+	CHECK_EQUAL(17, report.rssi);
+	CHECK_EQUAL(3, report.ber);
+
+	SIM808ChargingStatus charging = bench.sim.getChargingState();
+	CHECK(charging.state == SIM808ChargingState::Charging);
+	CHECK_EQUAL(64, charging.level);
+	CHECK_EQUAL(3900, charging.voltage);
+
+	char response[16];
+	CHECK_EQUAL(200, bench.sim.httpGet("http://example.com/", response, sizeof(response)));
+	CHECK_EQUAL("OK", response);
+}
+
+/**
+ * Not a check of speed, which depends on the host, but a report of it : run on its own with
+ *   test_ParseFields single_pass_speedup
+ */
+TEST(single_pass_speedup)
+{
+	Bench<> bench;
+	uint8_t state, level;
+	uint16_t voltage;
+	uint32_t sink = 0;
+
+	setReply(bench.sim, "+CBC: 1,64,3900\r\n");
+
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		bench.sim.parse(bench.sim.replyBuffer, ',', 0, &state);
+		bench.sim.parse(bench.sim.replyBuffer, ',', 1, &level);
+		bench.sim.parse(bench.sim.replyBuffer, ',', 2, &voltage);
+		sink += state + level + voltage;
+	}
+	auto indexed = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		bench.sim.parseReplyFields(',', &state, &level, &voltage);
+		sink -= state + level + voltage;
+	}
+	auto fields = std::chrono::steady_clock::now() - start;
+
+	CHECK_EQUAL(0u, sink);
+
+	double indexedNs = std::chrono::duration<double, std::nano>(indexed).count() / BENCHMARK_ITERATIONS;
+	double fieldsNs = std::chrono::duration<double, std::nano>(fields).count() / BENCHMARK_ITERATIONS;
+	printf("  3 fields : parse %.1f ns, parseReplyFields %.1f ns, speedup x%.2f\n", indexedNs, fieldsNs, indexedNs / fieldsNs);
+}
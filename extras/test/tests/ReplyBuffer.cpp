@@ -0,0 +1,54 @@
+#include "Fixture.h"
+
+template<typename T> static bool within(const T& instance, const char* p)
+{
+	return p >= (const char*)&instance && p < (const char*)&instance + sizeof(T);
+}
+
+TEST(gives_each_instance_its_own_reply_buffer)
+{
+	Bench<> first, second;
+
+	CHECK(first.sim.replyBuffer != second.sim.replyBuffer);
+	CHECK(within(first.sim, first.sim.replyBuffer));
+	CHECK_EQUAL((size_t)SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE, first.sim.replyBufferSize);
+
+	// both answering at once
+	first.modem.rssi = 10;
+	second.modem.rssi = 20;
+	first.sim.sendAT("+CSQ");
+	second.sim.sendAT("+CSQ");
+	CHECK_EQUAL(0, first.sim.waitResponse("+CSQ"));
+	CHECK_EQUAL(0, second.sim.waitResponse("+CSQ"));
+
+	uint8_t rssi;
+	CHECK(first.sim.parseReplyFields(',', &rssi));
+	CHECK_EQUAL(10, rssi);
+	CHECK(second.sim.parseReplyFields(',', &rssi));
+	CHECK_EQUAL(20, rssi);
+}
+
+TEST(holds_a_single_buffer_of_its_size)
+{
+	Bench<Probe<SIM808Buffered<128>>> larger;
+	Bench<Probe<SIM808Buffered<32>>> smaller;
+
+	CHECK(within(larger.sim, larger.sim.replyBuffer));
+	CHECK_EQUAL((size_t)128, larger.sim.replyBufferSize);
+	CHECK_EQUAL(sizeof(SIM808) + 128, sizeof(larger.sim));
+
+	CHECK(within(smaller.sim, smaller.sim.replyBuffer));
+	CHECK_EQUAL((size_t)32, smaller.sim.replyBufferSize);
+	CHECK_EQUAL(sizeof(SIM808) + 32, sizeof(smaller.sim));
+	CHECK(smaller.sim.setEcho(SIM808Echo::Off));
+}
+
+TEST(reads_gnss_sequences_in_one_pass_with_a_larger_buffer)
+{
+	Bench<Probe<SIM808Buffered<128>>> bench;
+	char position[128];
+
+	bench.modem.gnssPower = true;
+	CHECK(bench.sim.getGpsStatus(position, sizeof(position)) == SIM808GpsStatus::AccurateFix);
+	CHECK_EQUAL((size_t)0, std::string(position).find(bench.modem.gnssFix));
+}
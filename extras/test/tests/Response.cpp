@@ -0,0 +1,92 @@
+#include "Fixture.h"
+
+static int8_t completedWith;
+static uint8_t completions;
+
+static void recordCompletion(int8_t result)
+{
+	completedWith = result;
+	completions++;
+}
+
+/**
+ * Poll until the pending command completes, counting the polls.
+ */
+static SIMComATResponseStatus pollUntilDone(SIM808Probe& sim, uint32_t* polls)
+{
+	SIMComATResponseStatus status;
+
+	*polls = 0;
+	while((status = sim.poll()) == SIMComATResponseStatus::Pending) (*polls)++;
+
+	return status;
+}
+
+TEST(sends_commands_without_waiting_for_their_response)
+{
+	Bench<> bench;
+	uint32_t polls;
+	completions = 0;
+	bench.modem.setLatency("+CSQ", 100);
+
+	uint32_t start = millis();
+	CHECK(bench.sim.sendCommandAsync("+CSQ", recordCompletion));
+	CHECK(millis() - start < 5);
+	CHECK(bench.sim.responseStatus() == SIMComATResponseStatus::Pending);
+
+	// only one command may be pending at once
+	CHECK(!bench.sim.sendCommandAsync("+CSQ"));
+
+	CHECK(pollUntilDone(bench.sim, &polls) == SIMComATResponseStatus::Done);
+	CHECK(millis() - start >= 100);
+	// each poll with nothing to read moves the clock by at most 1 ms, they were not blocking
+	CHECK(polls >= 90);
+
+	CHECK_EQUAL(0, bench.sim.responseResult());
+	CHECK_EQUAL(1, completions);
+	CHECK_EQUAL(0, completedWith);
+	CHECK_EQUAL((size_t)1, bench.modem.commands.size());
+}
+
+TEST(completes_with_error)
+{
+	Bench<> bench;
+	uint32_t polls;
+	completions = 0;
+	bench.modem.fail("+CSQ");
+
+	CHECK(bench.sim.sendCommandAsync("+CSQ", recordCompletion));
+	CHECK(pollUntilDone(bench.sim, &polls) == SIMComATResponseStatus::Done);
+
+	CHECK_EQUAL(1, bench.sim.responseResult());
+	CHECK_EQUAL(1, completedWith);
+}
+
+TEST(times_out_without_response)
+{
+	Bench<> bench;
+	uint32_t polls;
+	completions = 0;
+	bench.modem.respond("+CSQ", "");
+
+	uint32_t start = millis();
+	CHECK(bench.sim.sendCommandAsync("+CSQ", recordCompletion, 200));
+	CHECK(pollUntilDone(bench.sim, &polls) == SIMComATResponseStatus::Timeout);
+
+	CHECK(millis() - start >= 200);
+	CHECK(millis() - start < 210);
+	CHECK_EQUAL(-1, bench.sim.responseResult());
+	CHECK_EQUAL(1, completions);
+	CHECK_EQUAL(-1, completedWith);
+
+	// the engine is free again
+	CHECK(bench.sim.sendCommandAsync("+CSQ", NULL, 200));
+}
+
+TEST(stays_idle_until_a_command_is_sent)
+{
+	Bench<> bench;
+
+	CHECK(bench.sim.poll() == SIMComATResponseStatus::Idle);
+	CHECK(bench.modem.commands.empty());
+}
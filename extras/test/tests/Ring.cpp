@@ -0,0 +1,129 @@
+#include "Fixture.h"
+#include "SIM808.FixBuffer.h"
+#include <thread>
+
+#define STRESS_BYTES 200000
+
+TEST(wraps_around_the_end_of_the_buffer)
+{
+	uint8_t storage[8];
+	SIMComATRing ring(storage, sizeof(storage));
+	uint8_t data[8];
+
+	// moving the indexes past the end, then across the 16 bits overflow
+	for(uint32_t i = 0; i < 70000; i += 5) {
+		const uint8_t written[5] = { (uint8_t)i, (uint8_t)(i + 1), (uint8_t)(i + 2), (uint8_t)(i + 3), (uint8_t)(i + 4) };
+
+		CHECK_EQUAL(5, ring.write(written, 5));
+		CHECK_EQUAL(5, ring.used());
+		CHECK_EQUAL(2, ring.copy(data, 2, 3));
+		CHECK_EQUAL((uint8_t)(i + 3), data[0]);
+		CHECK_EQUAL(5, ring.copy(data, sizeof(data)));
+		CHECK(memcmp(written, data, 5) == 0);
+
+		ring.release(5);
+		CHECK_EQUAL(0, ring.used());
+	}
+}
+
+TEST(stores_only_what_fits)
+{
+	uint8_t storage[4];
+	SIMComATRing ring(storage, sizeof(storage));
+	const uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+
+	CHECK_EQUAL(3, ring.write(data, 3));
+	CHECK_EQUAL(1, ring.write(data + 3, 3));
+	CHECK_EQUAL(0, ring.free());
+	CHECK_EQUAL(0, ring.write(data, 1));
+
+	CHECK_EQUAL(1, ring.read());
+	CHECK_EQUAL(2, ring.peek());
+	CHECK_EQUAL(1, ring.free());
+
+	ring.clear();
+	CHECK_EQUAL(0, ring.used());
+	CHECK_EQUAL(-1, ring.read());
+	CHECK_EQUAL(-1, ring.peek());
+}
+
+TEST(counts_the_bytes_dropped_by_the_receive_ring)
+{
+	SIMComATStaticRxRing<16> ring;
+	const uint8_t data[20] = { 0 };
+
+	CHECK_EQUAL((size_t)10, ring.push(data, 10));
+	CHECK_EQUAL((size_t)6, ring.push(data, 10));
+	CHECK(!ring.push(0));
+	CHECK_EQUAL(16, ring.highWaterMark());
+	CHECK_EQUAL(5, ring.overflows());
+
+	while(ring.read() != -1);
+	CHECK_EQUAL(0, ring.available());
+	CHECK_EQUAL(16, ring.highWaterMark());
+
+	ring.resetStatistics();
+	CHECK_EQUAL(0, ring.highWaterMark());
+	CHECK_EQUAL(0, ring.overflows());
+}
+
+TEST(hands_bytes_over_between_two_threads)
+{
+	SIMComATStaticRxRing<64> ring;
+	uint32_t mismatches = 0;
+
+	std::thread producer([&] {
+		for(uint32_t i = 0; i < STRESS_BYTES;) {
+			// yielding when full, the test machine may have a single core
+			if(ring.push((uint8_t)(i * 7))) i++;
+			else std::this_thread::yield();
+		}
+	});
+
+	for(uint32_t i = 0; i < STRESS_BYTES;) {
+		int c = ring.read();
+		if(c == -1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		if(c != (uint8_t)(i * 7)) mismatches++;
+		i++;
+	}
+
+	producer.join();
+	CHECK_EQUAL((uint32_t)0, mismatches);
+	CHECK_EQUAL(0, ring.available());
+}
+
+TEST(keeps_fix_records_whole)
+{
+	SIM808StaticFixRing<32> ring;
+	SIM808GnssFix fix = { 0 }, read;
+	uint8_t pushed = 0, popped = 0;
+
+	fix.runStatus = 1;
+	fix.fixStatus = 1;
+	fix.year = 2024;
+	fix.month = 2;
+	fix.day = 29;
+	fix.latitude = 48856614;
+	fix.longitude = 2352222;
+
+	// a keyframe, then small deltas, until a record does not fit
+	for(; pushed < 10; pushed++) {
+		fix.second = pushed;
+		if(!ring.push(fix)) break;
+	}
+	CHECK(pushed > 1 && pushed < 10);
+	CHECK(ring.used() <= 32);
+
+	while(ring.pop(&read)) {
+		CHECK_EQUAL(popped, read.second);
+		CHECK_EQUAL(48856614, read.latitude);
+		popped++;
+	}
+
+	CHECK_EQUAL(pushed, popped);
+	CHECK(ring.empty());
+}
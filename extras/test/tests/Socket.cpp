@@ -0,0 +1,186 @@
+#include "Fixture.h"
+#include <map>
+
+static void pollFor(SIM808Probe& sim, uint32_t ms)
+{
+	uint32_t start = millis();
+	while(millis() - start < ms) sim.poll();
+}
+
+static std::string readAll(SIM808Socket& socket)
+{
+	std::string data;
+	int c;
+
+	while((c = socket.read()) != -1) data += (char)c;
+	return data;
+}
+
+/**
+ * Open the sockets, and record the data sent over each link.
+ */
+static void openSockets(Bench<>& bench, std::map<uint8_t, std::string>& sent)
+{
+	bench.modem.attached = true;
+	bench.modem.setSocketPeer([&sent](uint8_t link, const std::string& data) { sent[link] += data; });
+
+	CHECK(bench.sim.openSockets("internet"));
+}
+
+TEST(echoes_data_over_a_connection)
+{
+	Bench<> bench;
+	SIM808StaticSocket<256> client(bench.sim);
+
+	bench.modem.attached = true;
+	CHECK(bench.sim.openSockets("internet"));
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+	CHECK(client.connected());
+
+	CHECK_EQUAL((size_t)5, client.write((const uint8_t*)"hello", 5));
+	pollFor(bench.sim, 500);
+
+	CHECK_EQUAL(5, client.available());
+	CHECK_EQUAL('h', client.peek());
+	CHECK_EQUAL(std::string("hello"), readAll(client));
+}
+
+TEST(demultiplexes_data_received_over_several_connections)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> first(bench.sim), second(bench.sim);
+	openSockets(bench, sent);
+
+	CHECK_EQUAL(1, first.connect("example.com", 1883));
+	CHECK_EQUAL(1, second.connectUdp("example.com", 53));
+	first.print("first");
+	uint8_t firstLink = sent.begin()->first;
+	second.print("second");
+	sent.erase(firstLink);
+	uint8_t secondLink = sent.begin()->first;
+
+	// the second one first, both in the same read
+	bench.modem.receive(secondLink, "to the second one");
+	bench.modem.receive(firstLink, "to the first one");
+	pollFor(bench.sim, 50);
+
+	CHECK_EQUAL(std::string("to the first one"), readAll(first));
+	CHECK_EQUAL(std::string("to the second one"), readAll(second));
+}
+
+TEST(sends_large_buffers_in_several_commands)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> client(bench.sim);
+	std::string data;
+	openSockets(bench, sent);
+
+	for(int i = 0; i < 2500; i++) data += (char)(i * 17);
+
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+	CHECK_EQUAL(data.size(), client.write((const uint8_t*)data.data(), data.size()));
+
+	CHECK(sent.begin()->second == data);
+	size_t sends = 0;
+	for(auto& command : bench.modem.commands) sends += command.find("+CIPSEND=") != std::string::npos;
+	CHECK_EQUAL((size_t)(2500 + SIM808_SOCKET_MAX_SEND - 1) / SIM808_SOCKET_MAX_SEND, sends);
+}
+
+TEST(reads_the_acceptance_of_the_last_chunk_without_blocking)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> client(bench.sim);
+	openSockets(bench, sent);
+
+	bench.modem.setLatency("DATA ACCEPT", 2000);
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+
+	uint32_t start = millis();
+	CHECK_EQUAL((size_t)5, client.write((const uint8_t*)"hello", 5));
+	CHECK(millis() - start < 2000);
+	CHECK(client.sending());
+	CHECK_EQUAL(std::string("hello"), sent.begin()->second);
+
+	pollFor(bench.sim, 1000);
+	CHECK(client.sending());
+
+	client.flush();
+	CHECK(!client.sending());
+	CHECK(!client.writeFailed());
+	CHECK(millis() - start >= 2000);
+}
+
+TEST(reports_a_refused_chunk)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> client(bench.sim);
+	openSockets(bench, sent);
+
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+	bench.modem.fail("+CIPSEND=");
+
+	CHECK_EQUAL((size_t)0, client.write((const uint8_t*)"hello", 5));
+	CHECK(!client.sending());
+	CHECK(client.writeFailed());
+}
+
+TEST(drops_what_does_not_fit_in_the_buffer)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<16> client(bench.sim);
+	openSockets(bench, sent);
+
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+	client.print("x");
+	bench.modem.receive(sent.begin()->first, std::string(20, 'r'));
+	pollFor(bench.sim, 50);
+
+	CHECK_EQUAL(16, client.available());
+	CHECK_EQUAL(4, client.dropped());
+
+	uint8_t buffer[32];
+	CHECK_EQUAL(16, client.read(buffer, sizeof(buffer)));
+	CHECK_EQUAL(0, client.available());
+}
+
+TEST(stays_connected_until_the_data_received_is_read)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> client(bench.sim);
+	openSockets(bench, sent);
+
+	CHECK_EQUAL(1, client.connect("example.com", 1883));
+	client.print("x");
+	uint8_t link = sent.begin()->first;
+
+	bench.modem.receive(link, "bye");
+	bench.modem.closeRemote(link, 10);
+	pollFor(bench.sim, 50);
+
+	CHECK(client.connected());
+	CHECK_EQUAL(std::string("bye"), readAll(client));
+	CHECK(!client.connected());
+}
+
+TEST(releases_the_link_when_stopped)
+{
+	Bench<> bench;
+	std::map<uint8_t, std::string> sent;
+	SIM808StaticSocket<256> clients[SIM808_MAX_SOCKETS + 1] = {
+		bench.sim, bench.sim, bench.sim, bench.sim, bench.sim, bench.sim, bench.sim
+	};
+	openSockets(bench, sent);
+
+	for(uint8_t i = 0; i < SIM808_MAX_SOCKETS; i++) CHECK_EQUAL(1, clients[i].connect("example.com", 1883));
+	CHECK(clients[SIM808_MAX_SOCKETS].connect("example.com", 1883) != 1);
+
+	clients[2].stop();
+	CHECK(!clients[2]);
+	CHECK_EQUAL(1, clients[SIM808_MAX_SOCKETS].connect("example.com", 1883));
+}
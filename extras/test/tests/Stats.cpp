@@ -0,0 +1,96 @@
+#include "Fixture.h"
+#include <sstream>
+#include <vector>
+
+#define CSV_FIELDS (6 + 2 * SIMCOMAT_STATS_BUCKETS)
+
+/**
+ * Split a CSV line, following RFC 4180 quoting. Returns false if it is malformed.
+ */
+static bool splitCsv(const std::string& line, std::vector<std::string>& fields)
+{
+	std::string field;
+	size_t i = 0;
+
+	fields.clear();
+	for(;;) {
+		field.clear();
+
+		if(i < line.size() && line[i] == '"') {
+			for(i++;; i++) {
+				if(i >= line.size()) return false;
+				if(line[i] != '"') field += line[i];
+				else if(i + 1 < line.size() && line[i + 1] == '"') field += line[++i];
+				else break;
+			}
+			i++;
+		}
+		else for(; i < line.size() && line[i] != ','; i++) field += line[i];
+
+		fields.push_back(field);
+
+		if(i == line.size()) return true;
+		if(line[i++] != ',') return false;
+	}
+}
+
+static std::vector<std::vector<std::string>> dump(SIM808Probe& sim)
+{
+	std::vector<std::vector<std::string>> rows;
+	std::vector<std::string> fields;
+	std::string line;
+	MemoryStream output;
+
+	sim.dumpStats(output);
+	std::istringstream lines(output.output);
+
+	while(std::getline(lines, line)) {
+		if(!line.empty() && line.back() == '\r') line.pop_back();
+		rows.push_back(splitCsv(line, fields) ? fields : std::vector<std::string>());
+	}
+
+	return rows;
+}
+
+static bool hasRow(const std::vector<std::vector<std::string>>& rows, const std::string& command)
+{
+	for(auto& row : rows) {
+		if(row.size() == CSV_FIELDS && row[0] == command) return true;
+	}
+
+	return false;
+}
+
+TEST(quotes_commands_in_csv)
+{
+	Bench<> bench;
+	SIM808ConnectionManager connection(bench.sim);
+
+	// a batch line is recorded under its first command, the bearer settings here
+	bench.modem.attached = true;
+	connection.begin("internet");
+	while(connection.tick() != SIM808ConnectionState::Connected);
+
+	auto rows = dump(bench.sim);
+	CHECK(rows.size() > 1);
+	for(auto& row : rows) CHECK_EQUAL((size_t)CSV_FIELDS, row.size());
+
+	CHECK(hasRow(rows, "+SAPBR=3,1,\"%S\",\"%s\""));
+}
+
+TEST(records_each_command)
+{
+	Bench<> bench;
+	char imei[16];
+
+	bench.sim.getSignalQuality();
+	bench.sim.getSignalQuality();
+	bench.sim.getImei(imei, sizeof(imei));
+	auto rows = dump(bench.sim);
+
+	CHECK_EQUAL((size_t)3, rows.size());
+	CHECK_EQUAL(std::string("command"), rows[0][0]);
+	CHECK_EQUAL(std::string("2"), rows[1][1]);
+	CHECK_EQUAL(std::string("1"), rows[2][1]);
+	CHECK_EQUAL(std::string("0"), rows[1][2]);
+}
@@ -0,0 +1,52 @@
+#include "Fixture.h"
+#include <cstring>
+
+#define SLOW_BAUDRATE 1200		///< Slow enough for each poll to receive a single byte.
+
+TEST(matches_tokens_received_a_byte_at_a_time)
+{
+	Bench<> bench;
+	bench.modem.setBaudrate(SLOW_BAUDRATE);
+	bench.modem.setHostBaudrate(SLOW_BAUDRATE);
+	bench.modem.rssi = 17;
+
+	bench.sim.sendAT("+CSQ");
+	CHECK_EQUAL(0, bench.sim.waitResponse(TO_F("+CSQ")));
+	CHECK_EQUAL(0, strncmp(bench.sim.replyBuffer, "+CSQ: 17,", 9));
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+}
+
+TEST(matches_tokens_at_the_start_of_lines_only)
+{
+	Bench<> bench;
+	bench.modem.respond("+TEST", "\r\nNO +MATCH\r\n\r\nERROR\r\n");
+
+	bench.sim.sendAT("+TEST");
+	CHECK_EQUAL(1, bench.sim.waitResponse(TO_F("+MATCH"), TO_F("ERROR")));
+}
+
+TEST(decides_lines_longer_than_the_reply_buffer)
+{
+	Bench<> bench;
+	std::string value(2 * SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE, 'x');
+	bench.modem.respond("+TEST", "\r\n+LONG: " + value + "\r\n\r\nOK\r\n");
+
+	bench.sim.sendAT("+TEST");
+	CHECK_EQUAL(0, bench.sim.waitResponse(TO_F("+LONG"), NULL));
+	CHECK_EQUAL(0, strncmp(bench.sim.replyBuffer, "+LONG: xxx", 10));
+
+	// the rest of the line is read as lines of its own, none of them matching
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+	CHECK_EQUAL(0, strncmp(bench.sim.replyBuffer, "OK", 2));
+}
+
+TEST(completes_data_prompts_without_new_line)
+{
+	Bench<> bench;
+	bench.modem.respond("+CMGS", "\r\n> ");
+
+	uint32_t start = millis();
+	bench.sim.sendAT("+CMGS=\"0600000000\"");
+	CHECK_EQUAL(0, bench.sim.waitResponse(5000, TO_F("> "), NULL));
+	CHECK(millis() - start < 100);
+}
@@ -0,0 +1,52 @@
+#include "Fixture.h"
+
+TEST(writes_each_short_line_at_once)
+{
+	Bench<> bench;
+	bench.modem.clearObservations();
+
+	bench.sim.sendAT("+CSQ");
+	CHECK_EQUAL(0, bench.sim.waitResponse());
+
+	CHECK_EQUAL((uint32_t)1, bench.modem.writeCalls);
+	CHECK_EQUAL(std::string("AT+CSQ"), bench.modem.commands.back());
+}
+
+TEST(writes_long_lines_in_buffer_sized_pieces)
+{
+	Bench<> bench;
+	std::string url = "http://example.com/" + std::string(200, 'u');
+	bench.modem.clearObservations();
+
+	bench.sim.sendAT("+HTTPPARA=\"URL\",\"", url.c_str(), "\"");
+	bench.sim.waitResponse();
+
+	std::string line = "AT+HTTPPARA=\"URL\",\"" + url + "\"";
+	CHECK_EQUAL(line, bench.modem.commands.back());
+	CHECK(bench.modem.writeCalls <= (line.size() + 2) / SIMCOMAT_TX_BUFFER_SIZE + 2);
+}
+
+TEST(writes_large_payloads_as_is)
+{
+	Bench<> bench;
+	uint8_t payload[300];
+	memset(payload, 'p', sizeof(payload));
+	bench.modem.clearObservations();
+
+	CHECK_EQUAL(sizeof(payload), bench.sim.write(payload, sizeof(payload)));
+	CHECK_EQUAL((uint32_t)1, bench.modem.writeCalls);
+	CHECK_EQUAL(std::string(300, 'p'), bench.modem.wire);
+}
+
+TEST(flushes_pending_bytes_before_reading)
+{
+	Bench<> bench;
+	bench.modem.clearObservations();
+
+	bench.sim.print("AT");
+	CHECK(bench.modem.wire.empty());
+
+	bench.sim.available();
+	CHECK_EQUAL(std::string("AT"), bench.modem.wire);
+	CHECK_EQUAL((uint32_t)1, bench.modem.writeCalls);
+}
@@ -0,0 +1,87 @@
+#include "Fixture.h"
+#include <vector>
+
+static std::vector<std::string> received;
+
+static void receiveLine(const char* line, size_t length)
+{
+	CHECK_EQUAL(strlen(line), length);
+	received.push_back(line);
+}
+
+static void ignoreLine(const char* line, size_t length) { }
+
+static void pollFor(SIM808Probe& sim, uint32_t ms)
+{
+	uint32_t start = millis();
+	while(millis() - start < ms) sim.poll();
+}
+
+TEST(dispatches_lines_received_while_idle)
+{
+	Bench<> bench;
+	received.clear();
+
+	CHECK(bench.sim.registerUrcHandler(TO_F("+CMTI"), receiveLine));
+	bench.modem.urc("+CMTI: \"SM\",3", 10);
+	bench.modem.urc("+CGREG: 5", 20);
+
+	pollFor(bench.sim, 50);
+	CHECK_EQUAL((size_t)1, received.size());
+	CHECK_EQUAL(std::string("+CMTI: \"SM\",3"), received[0]);
+}
+
+TEST(dispatches_lines_received_while_waiting_for_a_response)
+{
+	Bench<> bench;
+	received.clear();
+
+	CHECK(bench.sim.registerUrcHandler(TO_F("+CMTI"), receiveLine));
+	bench.modem.urc("+CMTI: \"SM\",4");
+
+	// the line must neither be lost nor be taken for the response
+	CHECK(bench.sim.getSignalQuality().rssi != 99);
+	CHECK_EQUAL((size_t)1, received.size());
+	CHECK_EQUAL(std::string("+CMTI: \"SM\",4"), received[0]);
+}
+
+TEST(streams_lines_to_an_output)
+{
+	Bench<> bench;
+	MemoryStream output;
+	std::string longLine = "+LONG: " + std::string(300, 'x');
+
+	CHECK(bench.sim.registerUrcHandler(TO_F("+LONG"), output));
+	bench.modem.urc(longLine);
+	pollFor(bench.sim, 50);
+
+	// longer than the reply buffer, and still received whole
+	CHECK(output.output.find(std::string(300, 'x')) != std::string::npos);
+}
+
+TEST(stops_dispatching_once_unregistered)
+{
+	Bench<> bench;
+	received.clear();
+
+	CHECK(bench.sim.registerUrcHandler(TO_F("+CMTI"), receiveLine));
+	bench.sim.unregisterUrcHandler(TO_F("+CMTI"));
+	bench.modem.urc("+CMTI: \"SM\",5");
+
+	pollFor(bench.sim, 50);
+	CHECK(received.empty());
+}
+
+TEST(holds_a_limited_number_of_handlers)
+{
+	Bench<> bench;
+	const char* prefixes[] = { "+A", "+B", "+C", "+D", "+E", "+F", "+G", "+H", "+I", "+J", "+K", "+L", "+M" };
+	uint8_t registered = 0;
+
+	while(registered < 13 && bench.sim.registerUrcHandler(TO_F(prefixes[registered]), ignoreLine)) registered++;
+	CHECK_EQUAL(SIMCOMAT_MAX_URC_HANDLERS, registered);
+
+	// freeing one makes room for another
+	bench.sim.unregisterUrcHandler(TO_F("+A"));
+	CHECK(bench.sim.registerUrcHandler(TO_F("+Z"), ignoreLine));
+}
@@ -0,0 +1,162 @@
+#include "Fixture.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define WORKER_THREADS 4
+#define WORKER_CALLS 25
+
+static int32_t readSignalQuality(SIM808& sim808, void* context)
+{
+	return sim808.getSignalQuality().rssi;
+}
+
+struct Gate
+{
+	SIM808WorkerSignal started;
+	SIM808WorkerSignal released;
+};
+
+static int32_t block(SIM808& sim808, void* context)
+{
+	Gate* gate = (Gate*)context;
+
+	gate->started.give();
+	gate->released.take();
+	return 0;
+}
+
+TEST(serializes_jobs_submitted_from_several_threads)
+{
+	Bench<> bench;
+	SIM808Worker worker(bench.sim);
+	std::atomic<int> matching(0);
+	std::vector<std::thread> threads;
+
+	bench.modem.rssi = 17;
+	CHECK(worker.begin());
+
+	for(int i = 0; i < WORKER_THREADS; i++) {
+		threads.emplace_back([&] {
+			for(int j = 0; j < WORKER_CALLS; j++) {
+				if(worker.call(readSignalQuality) == 17) matching++;
+			}
+		});
+	}
+
+	for(auto& thread : threads) thread.join();
+	worker.end();
+
+	CHECK_EQUAL(WORKER_THREADS * WORKER_CALLS, matching.load());
+	CHECK_EQUAL((size_t)WORKER_THREADS * WORKER_CALLS, bench.modem.commands.size());
+}
+
+static std::vector<int32_t> order;
+
+static int32_t recordOrder(SIM808& sim808, void* context)
+{
+	order.push_back((int32_t)(intptr_t)context);
+	return (int32_t)order.size();
+}
+
+TEST(runs_higher_priorities_first)
+{
+	Bench<> bench;
+	SIM808Worker worker(bench.sim);
+	Gate gate;
+	SIM808Request blocking(block, &gate);
+	SIM808Request low(recordOrder, (void*)3), normal(recordOrder, (void*)2), high(recordOrder, (void*)1);
+	order.clear();
+
+	CHECK(worker.begin());
+	CHECK(worker.submit(blocking));
+
+	// queued while the worker is busy with the blocking job
+	CHECK(gate.started.take(1000));
+	CHECK(worker.submit(low, SIM808WorkerPriority::Low));
+	CHECK(worker.submit(normal, SIM808WorkerPriority::Normal));
+	CHECK(worker.submit(high, SIM808WorkerPriority::High));
+	gate.released.give();
+
+	CHECK(low.wait(1000));
+	worker.end();
+
+	CHECK_EQUAL((size_t)3, order.size());
+	CHECK_EQUAL(1, order[0]);
+	CHECK_EQUAL(2, order[1]);
+	CHECK_EQUAL(3, order[2]);
+}
+
+static std::atomic<int> callbacks;
+
+static void countCallback(int32_t result, void* context)
+{
+	// the submitting thread must still be waiting meanwhile
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	callbacks++;
+}
+
+TEST(completes_requests_once_their_callback_has_returned)
+{
+	Bench<> bench;
+	SIM808Worker worker(bench.sim);
+	callbacks = 0;
+
+	CHECK(worker.begin());
+
+	for(int i = 0; i < 20; i++) {
+		// destroyed as soon as waited for, the worker must not touch it afterwards
+		SIM808Request request(readSignalQuality, NULL, countCallback);
+
+		CHECK(worker.submit(request));
+		CHECK(request.wait(1000));
+		CHECK(request.completed());
+		CHECK_EQUAL(i + 1, callbacks.load());
+	}
+
+	worker.end();
+}
+
+TEST(reports_requests_not_run_in_time)
+{
+	Bench<> bench;
+	SIM808Worker worker(bench.sim);
+	Gate gate;
+	SIM808Request blocking(block, &gate);
+
+	CHECK(worker.begin());
+	CHECK(worker.submit(blocking));
+
+	CHECK(!blocking.wait(20));
+	CHECK(!blocking.completed());
+
+	gate.released.give();
+	CHECK(blocking.wait(1000));
+	worker.end();
+}
+
+static int32_t sendQuery(SIM808& sim808, void* context)
+{
+	uint32_t* ticks = (uint32_t*)context;
+
+	if(sim808.responseStatus() == SIMComATResponseStatus::Pending) sim808.poll();
+	// leaving room for requests between two queries
+	else if((*ticks)++ % 2) sim808.sendCommandAsync("+CSQ");
+
+	return 0;
+}
+
+TEST(waits_for_the_response_awaited_by_the_idle_job)
+{
+	Bench<> bench;
+	SIM808Worker worker(bench.sim);
+	uint32_t ticks = 0;
+
+	worker.setIdleJob(sendQuery, &ticks);
+	CHECK(worker.begin());
+
+	// answered correctly only if not run while the idle job awaits its own response
+	for(int i = 0; i < 5; i++) CHECK(worker.call(readSignalQuality) != 99);
+
+	worker.end();
+}
@@ -0,0 +1,200 @@
+#include "SIM808.h"
+#include "SIM808.Gprs.h"
+
+
+#define BEARER_CONNECTING 0
+#define BEARER_CONNECTED 1
+
+SIM808ConnectionManager::SIM808ConnectionManager(SIM808& sim808)
+{
+	_sim808 = &sim808;
+	_step = Step::Idle;
+	_pending = false;
+	_draining = false;
+	_attempts = 0;
+}
+
+void SIM808ConnectionManager::begin(const char* apn, const char* user, const char* password)
+{
+	_apn = apn;
+	_user = user;
+	_password = password;
+	_attempts = 0;
+	// a command sent before is still awaited, its result is meaningless now
+	_draining = _pending;
+
+	next(Step::CheckRegistration);
+}
+
+void SIM808ConnectionManager::end()
+{
+	_draining = _pending;
+	_step = Step::Idle;
+}
+
+SIM808ConnectionState SIM808ConnectionManager::tick()
+{
+	SIMComATResponseStatus status;
+
+	if(_pending) {
+		status = _sim808->pollResponse();
+		if(status == SIMComATResponseStatus::Pending) return state();
+
+		_pending = false;
+		if(_draining) _draining = false;
+		else complete(status == SIMComATResponseStatus::Done ? _sim808->responseResult() : -1);
+	}
+	else if(_step != Step::Idle &&
+		(int32_t)(millis() - _nextAction) >= 0 &&
+		_sim808->responseStatus() != SIMComATResponseStatus::Pending) act();
+	else _sim808->poll();
+
+	return state();
+}
+
+SIM808ConnectionState SIM808ConnectionManager::state()
+{
+	switch(_step) {
+		case Step::CheckRegistration: return SIM808ConnectionState::Registering;
+		case Step::CheckAttach:
+		case Step::Attach: return SIM808ConnectionState::Attaching;
+		case Step::CheckBearer:
+		case Step::SetBearer:
+		case Step::OpenBearer: return SIM808ConnectionState::OpeningBearer;
+		// the device is busy until the check and its final result have been read
+		case Step::Connected:
+		case Step::CheckConnection: return _pending ? SIM808ConnectionState::Checking : SIM808ConnectionState::Connected;
+		default: return SIM808ConnectionState::Idle;
+	}
+}
+
+void SIM808ConnectionManager::act()
+{
+	ATCommand command;
+
+	switch(_step) {
+		case Step::CheckRegistration:
+			command = AT_NETWORK_REGISTRATION_READ;
+			_sim808->sendCommandAT(command);								//AT+CGREG?
+			break;
+		case Step::CheckBearer:
+		case Step::CheckConnection:
+			command = AT_BEARER_STATUS;
+			_sim808->sendCommandAT(command, 2, 1);							//AT+SAPBR=2,1
+			break;
+		case Step::CheckAttach:
+			command = AT_GPRS_ATTACH_READ;
+			_sim808->sendCommandAT(command);								//AT+CGATT?
+			break;
+		case Step::Attach:
+			command = AT_GPRS_ATTACH;
+			_sim808->sendCommandAT(command, 1);								//AT+CGATT=1
+			break;
+		case Step::SetBearer:
+			_sim808->beginBatch();
+			if(!_sim808->batchBearerSettings(_apn, _user, _password) ||		//AT+SAPBR=3,1,"CONTYPE","GPRS";+SAPBR=3,1,"APN","xxx"...
+				!_sim808->endBatchAsync()) {
+				retry();
+				return;
+			}
+
+			_pending = true;
+			return;
+		case Step::OpenBearer:
+			command = AT_BEARER;
+			_sim808->sendCommandAT(command, 1, 1);							//AT+SAPBR=1,1
+			break;
+		case Step::Connected:
+			next(Step::CheckConnection);
+			act();
+			return;
+		default:
+			return;
+	}
+
+	_sim808->beginResponse(command.timeout, command.response ? TO_F(command.response) : TO_F(TOKEN_OK));
+	_pending = true;
+}
+
+void SIM808ConnectionManager::complete(int8_t result)
+{
+	uint8_t value;
+
+	if(result != 0) {
+		retry();
+		return;
+	}
+
+	switch(_step) {
+		case Step::CheckRegistration:
+			if(!_sim808->parseReply(',', (uint8_t)SIM808RegistrationStatusResponse::Stat, &value)) break;
+
+			if(value == (uint8_t)SIM808NetworkRegistrationState::Registered ||
+				value == (uint8_t)SIM808NetworkRegistrationState::Roaming) next(Step::CheckBearer);
+			else retry();
+
+			drain();
+			return;
+		case Step::CheckBearer:
+		case Step::CheckConnection:
+			// +SAPBR: <cid>,<status>,<ip>
+			if(!_sim808->parseReply(',', 1, &value)) break;
+
+			if(value == BEARER_CONNECTED) {
+				_attempts = 0;
+				next(Step::Connected, SIM808_CONNECTION_CHECK_INTERVAL);
+			}
+			else if(value == BEARER_CONNECTING) next(_step, SIM808_CONNECTION_BACKOFF_MIN);
+			else next(Step::CheckAttach);
+
+			drain();
+			return;
+		case Step::CheckAttach:
+			if(!_sim808->parseReply(',', 0, &value)) break;
+
+			next(value ? Step::SetBearer : Step::Attach);
+			drain();
+			return;
+		case Step::Attach:
+			next(Step::SetBearer);
+			return;
+		case Step::SetBearer:
+			next(Step::OpenBearer);
+			return;
+		case Step::OpenBearer:
+			_attempts = 0;
+			next(Step::Connected, SIM808_CONNECTION_CHECK_INTERVAL);
+			return;
+		default:
+			return;
+	}
+
+	// the information response could not be parsed
+	retry();
+	drain();
+}
+
+void SIM808ConnectionManager::next(Step step, uint32_t delay)
+{
+	_step = step;
+	_nextAction = millis() + delay;
+}
+
+void SIM808ConnectionManager::retry()
+{
+	uint32_t delay = SIM808_CONNECTION_BACKOFF_MIN;
+
+	for(uint8_t i = 0; i < _attempts && delay < SIM808_CONNECTION_BACKOFF_MAX; i++) delay <<= 1;
+	if(delay > SIM808_CONNECTION_BACKOFF_MAX) delay = SIM808_CONNECTION_BACKOFF_MAX;
+	if(_attempts < UINT8_MAX) _attempts++;
+
+	// anywhere in the upper half of the delay
+	next(Step::CheckRegistration, delay / 2 + random(delay / 2 + 1));
+}
+
+void SIM808ConnectionManager::drain()
+{
+	_sim808->beginResponse(SIMCOMAT_DEFAULT_TIMEOUT);
+	_pending = true;
+	_draining = true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIMComAT.Common.h"
+#include "SIM808.Types.h"
+
+#define SIM808_CONNECTION_BACKOFF_MIN 1000		///< Delay before the first retry of a failed step, in ms.
+#define SIM808_CONNECTION_BACKOFF_MAX 60000		///< Longest delay between two retries, in ms.
+#define SIM808_CONNECTION_CHECK_INTERVAL 30000	///< Delay between two checks of an open bearer, in ms.
+
+class SIM808;
+
+/**
+ * Brings a GPRS bearer up, and keeps it up, without ever blocking on a long command :
+ * network registration, then GPRS attach, then bearer opening.
+ * Each step is first queried (AT+CGREG?, AT+SAPBR=2,1, AT+CGATT?) so that the
+ * steps already done, such as after a short coverage drop, are skipped.
+ * Failed steps are retried after an exponential backoff, randomized to
+ * avoid every device of a fleet retrying at once.
+ *
+ * tick() polls the device itself and must be called from loop() instead of SIM808::poll().
+ */
+class SIM808ConnectionManager
+{
+private:
+	/**
+	 * Next command of the state machine.
+	 */
+	enum class Step : uint8_t
+	{
+		Idle,
+		CheckRegistration,
+		CheckBearer,
+		CheckAttach,
+		Attach,
+		SetBearer,
+		OpenBearer,
+		Connected,
+		CheckConnection		///< Periodic check of an open bearer.
+	};
+
+	SIM808* _sim808;
+	const char* _apn;
+	const char* _user;
+	const char* _password;
+	Step _step;
+	bool _pending;			///< A response to the last command is awaited.
+	bool _draining;			///< The OK following an information response is awaited.
+	uint8_t _attempts;		///< Failures since the bearer was last open.
+	uint32_t _nextAction;
+
+	/**
+	 * Send the command of the current step.
+	 */
+	void act();
+	/**
+	 * Move to the next step according to the result of the current one.
+	 */
+	void complete(int8_t result);
+	/**
+	 * Move to step, with or without waiting.
+	 */
+	void next(Step step, uint32_t delay = 0);
+	/**
+	 * Start over from the network registration after a randomized, exponentially growing delay.
+	 */
+	void retry();
+	/**
+	 * Await the OK following an information response, ignoring it.
+	 */
+	void drain();
+
+public:
+	SIM808ConnectionManager(SIM808& sim808);
+
+	/**
+	 * Start bringing the bearer up with the given settings, which must outlive the manager.
+	 */
+	void begin(const char* apn, const char* user = NULL, const char* password = NULL);
+	/**
+	 * Stop managing the connection. The bearer is left as is, see SIM808::disableGprs.
+	 */
+	void end();
+	/**
+	 * Advance the connection by at most one command, and poll the device.
+	 * Never waits for a response.
+	 */
+	SIM808ConnectionState tick();
+
+	SIM808ConnectionState state();
+	bool connected() { return state() == SIM808ConnectionState::Connected; }
+	/**
+	 * Get the number of failures since the bearer was last open.
+	 */
+	uint8_t attempts() { return _attempts; }
+};
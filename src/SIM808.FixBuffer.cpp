@@ -0,0 +1,209 @@
+#include "SIM808.FixBuffer.h"
+
+#define FIX_HEADER_RUN 0x01
+#define FIX_HEADER_FIX 0x02
+#define FIX_HEADER_KEYFRAME 0x80
+
+#define DAYS_TO_2000 146037UL	///< Days from 1600-03-01 to 2000-01-01.
+#define DAYS_PER_ERA 146097UL	///< Days in 400 years.
+
+static uint32_t toSeconds(const SIM808GnssFix& fix)
+{
+	if(fix.year < 2000 || !fix.month) return 0;
+
+	// counting from march, so that leap days come last
+	uint32_t year = fix.year - 1600 - (fix.month <= 2);
+	uint8_t month = fix.month <= 2 ? fix.month + 9 : fix.month - 3;
+	uint32_t days = 365 * year + year / 4 - year / 100 + year / 400 + (153 * month + 2) / 5 + fix.day - 1 - DAYS_TO_2000;
+
+	return ((days * 24 + fix.hour) * 60 + fix.minute) * 60 + fix.second;
+}
+
+static void fromSeconds(uint32_t seconds, SIM808GnssFix* fix)
+{
+	if(!seconds) return;
+
+	fix->second = seconds % 60;
+	seconds /= 60;
+	fix->minute = seconds % 60;
+	seconds /= 60;
+	fix->hour = seconds % 24;
+
+	uint32_t days = seconds / 24 + DAYS_TO_2000;
+	uint32_t era = days / DAYS_PER_ERA;
+	uint32_t dayOfEra = days - era * DAYS_PER_ERA;
+	uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	uint16_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	uint8_t month = (5 * dayOfYear + 2) / 153;
+
+	fix->day = dayOfYear - (153 * month + 2) / 5 + 1;
+	fix->month = month < 10 ? month + 3 : month - 9;
+	fix->year = 1600 + era * 400 + yearOfEra + (fix->month <= 2);
+}
+
+static void toValues(const SIM808GnssFix& fix, int32_t* values)
+{
+	values[0] = toSeconds(fix);
+	values[1] = fix.latitude;
+	values[2] = fix.longitude;
+	values[3] = fix.altitude;
+	values[4] = fix.speed;
+	values[5] = fix.course;
+	values[6] = fix.hdop;
+	values[7] = fix.gnssUsed;
+}
+
+static void fromValues(const int32_t* values, SIM808GnssFix* fix)
+{
+	fromSeconds(values[0], fix);
+	fix->latitude = values[1];
+	fix->longitude = values[2];
+	fix->altitude = values[3];
+	fix->speed = values[4];
+	fix->course = values[5];
+	fix->hdop = values[6];
+	fix->gnssUsed = values[7];
+}
+
+static uint8_t writeVarint(uint8_t* data, int32_t value)
+{
+	uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+	uint8_t length = 0;
+
+	while(zigzag >= 0x80) {
+		data[length++] = (zigzag & 0x7F) | 0x80;
+		zigzag >>= 7;
+	}
+
+	data[length++] = zigzag;
+	return length;
+}
+
+static uint8_t readVarint(const uint8_t* data, size_t size, int32_t* value)
+{
+	uint32_t zigzag = 0;
+
+	for(uint8_t i = 0; i < size && i < 5; i++) {
+		zigzag |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+		if(data[i] & 0x80) continue;
+
+		*value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+		return i + 1;
+	}
+
+	return 0;
+}
+
+SIM808FixEncoder::SIM808FixEncoder()
+{
+	_keyframe = true;
+}
+
+uint8_t SIM808FixEncoder::encode(const SIM808GnssFix& fix, uint8_t* record)
+{
+	int32_t values[SIM808_FIX_FIELDS];
+	uint8_t length = 1;
+
+	toValues(fix, values);
+	record[0] = (fix.runStatus ? FIX_HEADER_RUN : 0) |
+		(fix.fixStatus ? FIX_HEADER_FIX : 0) |
+		(_keyframe ? FIX_HEADER_KEYFRAME : 0);
+
+	for(uint8_t i = 0; i < SIM808_FIX_FIELDS; i++) {
+		// differences are computed unsigned, wrapping around instead of overflowing
+		int32_t value = _keyframe ? values[i] : (int32_t)((uint32_t)values[i] - (uint32_t)_previous[i]);
+		length += writeVarint(record + length, value);
+		_previous[i] = values[i];
+	}
+
+	_keyframe = false;
+	return length;
+}
+
+SIM808FixDecoder::SIM808FixDecoder()
+{
+	memset(_previous, 0, sizeof(_previous));
+}
+
+uint8_t SIM808FixDecoder::decode(const uint8_t* data, size_t size, SIM808GnssFix* fix)
+{
+	int32_t values[SIM808_FIX_FIELDS];
+	uint8_t length = 1;
+
+	if(!size) return 0;
+
+	for(uint8_t i = 0; i < SIM808_FIX_FIELDS; i++) {
+		uint8_t read = readVarint(data + length, size - length, &values[i]);
+		if(!read) return 0;
+
+		length += read;
+		if(!(data[0] & FIX_HEADER_KEYFRAME)) values[i] = (uint32_t)values[i] + (uint32_t)_previous[i];
+	}
+
+	memcpy(_previous, values, sizeof(_previous));
+
+	memset(fix, 0, sizeof(SIM808GnssFix));
+	fix->runStatus = data[0] & FIX_HEADER_RUN ? 1 : 0;
+	fix->fixStatus = data[0] & FIX_HEADER_FIX ? 1 : 0;
+	fromValues(values, fix);
+
+	return length;
+}
+
+SIM808FixRing::SIM808FixRing(uint8_t* buffer, uint16_t size) : _ring(buffer, size) { }
+
+bool SIM808FixRing::push(const SIM808GnssFix& fix)
+{
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808FixEncoder encoder = _encoder;	// only moving forward once the record is stored
+	uint8_t length = encoder.encode(fix, record);
+
+	// records are stored whole or not at all
+	if(_ring.free() < length) return false;
+
+	_ring.write(record, length);
+	_encoder = encoder;
+	return true;
+}
+
+bool SIM808FixRing::peek(SIM808GnssFix* fix)
+{
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808FixDecoder decoder = _decoder;
+
+	return decoder.decode(record, _ring.copy(record, sizeof(record)), fix) != 0;
+}
+
+bool SIM808FixRing::pop(SIM808GnssFix* fix)
+{
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808GnssFix discarded;
+
+	uint8_t length = _decoder.decode(record, _ring.copy(record, sizeof(record)), fix ? fix : &discarded);
+	if(!length) return false;
+
+	_ring.release(length);
+	return true;
+}
+
+size_t SIM808FixRing::popFrame(uint8_t* frame, size_t size)
+{
+	uint8_t record[SIM808_FIX_MAX_RECORD_SIZE];
+	SIM808FixEncoder encoder;
+	SIM808GnssFix fix;
+	size_t length = 1;
+
+	if(!size) return 0;
+	frame[0] = SIM808_FIX_FRAME_VERSION;
+
+	while(peek(&fix)) {
+		uint8_t recordLength = encoder.encode(fix, record);
+		if(length + recordLength > size) break;
+
+		memcpy(frame + length, record, recordLength);
+		length += recordLength;
+		pop();
+	}
+
+	return length > 1 ? length : 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIM808.Types.h"
+#include "SIMComAT.Ring.h"
+
+#define SIM808_FIX_FIELDS 8				///< Number of SIM808GnssFix values kept in a record.
+#define SIM808_FIX_MAX_RECORD_SIZE 41	///< Header byte, and one varint of at most 5 bytes per value.
+#define SIM808_FIX_FRAME_VERSION 1		///< First byte of every frame.
+
+/**
+ * Encodes fixes into compact binary records, each one delta-encoded against the previous one.
+ *
+ * A record is a header byte (bit 0 : run status, bit 1 : fix status, bit 7 : keyframe), followed by
+ * zigzag varints for the UTC date time (seconds since 2000-01-01), latitude, longitude, altitude,
+ * speed, course, HDOP and GNSS satellites used. Keyframes hold the values themselves, other records
+ * the difference with the previous record. Milliseconds and the remaining fields are not kept.
+ *
+ * A stationary or slowly moving tracker typically needs 9 to 14 bytes per fix.
+ */
+class SIM808FixEncoder
+{
+private:
+	int32_t _previous[SIM808_FIX_FIELDS];
+	bool _keyframe;
+
+public:
+	SIM808FixEncoder();
+
+	/**
+	 * Make the next record a keyframe.
+	 */
+	void reset() { _keyframe = true; }
+	/**
+	 * Encode fix into record, which must hold at least SIM808_FIX_MAX_RECORD_SIZE bytes.
+	 * Returns the length of the record.
+	 */
+	uint8_t encode(const SIM808GnssFix& fix, uint8_t* record);
+};
+
+/**
+ * Decodes the records written by a SIM808FixEncoder, in the same order.
+ */
+class SIM808FixDecoder
+{
+private:
+	int32_t _previous[SIM808_FIX_FIELDS];
+
+public:
+	SIM808FixDecoder();
+
+	/**
+	 * Decode the record at the start of data into fix. Fields that are not kept are zeroed.
+	 * Returns the length of the record, or 0 if data does not hold a complete record.
+	 */
+	uint8_t decode(const uint8_t* data, size_t size, SIM808GnssFix* fix);
+};
+
+/**
+ * Fixed capacity ring of delta-encoded fixes, for one producer and one consumer.
+ * push may be called from an interrupt or a callback while loop pops, without locks.
+ *
+ * The records are stored in a caller provided buffer, whose size must be a power of two
+ * of at most 32768 bytes. See SIM808StaticFixRing.
+ */
+class SIM808FixRing
+{
+private:
+	SIMComATRing _ring;
+	SIM808FixEncoder _encoder;
+	SIM808FixDecoder _decoder;
+
+public:
+	SIM808FixRing(uint8_t* buffer, uint16_t size);
+
+	/**
+	 * Add fix to the ring. Returns false, leaving the ring untouched, if it is full.
+	 */
+	bool push(const SIM808GnssFix& fix);
+	/**
+	 * Read the oldest fix of the ring, without removing it.
+	 */
+	bool peek(SIM808GnssFix* fix);
+	/**
+	 * Remove the oldest fix of the ring, reading it into fix unless it is NULL.
+	 */
+	bool pop(SIM808GnssFix* fix = NULL);
+	/**
+	 * Get the number of bytes used by the stored records.
+	 */
+	uint16_t used() { return _ring.used(); }
+	/**
+	 * Get a boolean indicating wether or not the ring is empty.
+	 */
+	bool empty() { return used() == 0; }
+
+	/**
+	 * Pop as many fixes as fit into frame : a SIM808_FIX_FRAME_VERSION byte, followed by the
+	 * records of the fixes, starting with a keyframe so that each frame can be decoded on its own.
+	 * Returns the length of the frame, or 0 if the ring is empty or frame is too small for a single fix.
+	 */
+	size_t popFrame(uint8_t* frame, size_t size);
+};
+
+/**
+ * SIM808FixRing storing its records in Size bytes of its own.
+ */
+template<uint16_t Size>
+class SIM808StaticFixRing : public SIM808FixRing
+{
+	static_assert(Size && !(Size & (Size - 1)) && Size <= 32768, "Size must be a power of two of at most 32768");
+
+private:
+	uint8_t _storage[Size];
+
+public:
+	SIM808StaticFixRing() : SIM808FixRing(_storage, Size) { }
+};
@@ -0,0 +1,132 @@
+#include "SIM808.GnssParser.h"
+#include "SIMComAT.Common.h"
+
+#define GNSS_FIELD_UTC 2
+#define GNSS_FIELDS 21
+
+/**
+ * Number of decimals kept for each +CGNSINF field.
+ */
+const uint8_t GNSS_FIELD_SCALES[GNSS_FIELDS] S_PROGMEM = {
+	0, 0,		// run status, fix status
+	3,			// UTC, milliseconds
+	6, 6,		// latitude, longitude, microdegrees
+	2, 3, 2,	// altitude (cm), speed (m/h), course (1/100 degree)
+	0, 0,		// fix mode, reserved
+	2, 2, 2,	// HDOP, PDOP, VDOP
+	0, 0, 0, 0,	// reserved, GPS in view, GNSS used, GLONASS in view
+	0, 0,		// reserved, C/N0 max
+	2, 2		// HPA, VPA (cm)
+};
+
+void SIM808GnssParser::begin(SIM808GnssFix* fix)
+{
+	_fix = fix;
+	memset(_fix, 0, sizeof(SIM808GnssFix));
+
+	_field = 0;
+	_done = false;
+	_digits = 0;
+	_decimals = -1;
+	_negative = false;
+	_value = 0;
+}
+
+size_t SIM808GnssParser::write(uint8_t c)
+{
+	if(_done) return 0;
+
+	if(c == ',') {
+		endField();
+		return 1;
+	}
+
+	if(c == '\n') {
+		endField();
+		_done = true;
+		return 1;
+	}
+
+	if(c == '-') _negative = true;
+	else if(c == '.') _decimals = 0;
+	else if(c >= '0' && c <= '9') {
+		uint8_t digit = c - '0';
+
+		if(_decimals < 0) {
+			_value = _value * 10 + digit;
+			_digits++;
+
+			// UTC date time is yyyyMMddhhmmss, flushing each component as it is complete
+			if(_field == GNSS_FIELD_UTC && _digits >= 4 && !(_digits % 2)) {
+				switch(_digits) {
+					case 4: _fix->year = _value; break;
+					case 6: _fix->month = _value; break;
+					case 8: _fix->day = _value; break;
+					case 10: _fix->hour = _value; break;
+					case 12: _fix->minute = _value; break;
+					case 14: _fix->second = _value; break;
+				}
+				_value = 0;
+			}
+		}
+		else if(_field < GNSS_FIELDS && _decimals < (int8_t)pgm_read_byte(&GNSS_FIELD_SCALES[_field])) {
+			_value = _value * 10 + digit;
+			_decimals++;
+		}
+	}
+
+	return 1;
+}
+
+void SIM808GnssParser::endField()
+{
+	if(_field < GNSS_FIELDS) {
+		uint8_t scale = pgm_read_byte(&GNSS_FIELD_SCALES[_field]);
+		for(int8_t i = _decimals < 0 ? 0 : _decimals; i < scale; i++) _value *= 10;
+
+		int32_t value = _negative ? -(int32_t)_value : _value;
+
+		switch(_field) {
+			case 0: _fix->runStatus = value; break;
+			case 1: _fix->fixStatus = value; break;
+			case GNSS_FIELD_UTC: _fix->millisecond = value; break;
+			case 3: _fix->latitude = value; break;
+			case 4: _fix->longitude = value; break;
+			case 5: _fix->altitude = value; break;
+			case 6: _fix->speed = value; break;
+			case 7: _fix->course = value; break;
+			case 8: _fix->fixMode = value; break;
+			case 10: _fix->hdop = value; break;
+			case 11: _fix->pdop = value; break;
+			case 12: _fix->vdop = value; break;
+			case 14: _fix->gpsInView = value; break;
+			case 15: _fix->gnssUsed = value; break;
+			case 16: _fix->glonassInView = value; break;
+			case 18: _fix->cn0Max = value; break;
+			case 19: _fix->hpa = value; break;
+			case 20: _fix->vpa = value; break;
+		}
+	}
+
+	_field++;
+	_digits = 0;
+	_decimals = -1;
+	_negative = false;
+	_value = 0;
+}
+
+SIM808GnssStream::SIM808GnssStream(SIM808GnssFixCallback callback)
+{
+	_callback = callback;
+	begin(&_fix);
+}
+
+size_t SIM808GnssStream::write(uint8_t c)
+{
+	SIM808GnssParser::write(c);
+	if(!done()) return 1;
+
+	_callback(_fix);
+	begin(&_fix);
+	return 1;
+}
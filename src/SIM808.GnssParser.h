@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIM808.Types.h"
+
+/**
+ * Parses a +CGNSINF sequence (without its header) into a SIM808GnssFix, one character at a time,
+ * in a single left to right pass and with fixed point arithmetic only.
+ * Characters are fed through the Print interface, so the sequence can be parsed while it is being received.
+ * The sequence ends on a new line, carriage returns are ignored.
+ */
+class SIM808GnssParser : public Print
+{
+private:
+	SIM808GnssFix* _fix;
+	uint8_t _field;
+	uint8_t _digits;	///< Digits read in the integer part of the current field.
+	int8_t _decimals;	///< Digits read in the decimal part of the current field, -1 before the decimal point.
+	bool _negative;
+	uint32_t _value;
+	bool _done;
+
+	/**
+	 * Store the current field value at the right scale, and get ready for the next one.
+	 */
+	void endField();
+
+public:
+	/**
+	 * Start parsing a new sequence into fix.
+	 */
+	void begin(SIM808GnssFix* fix);
+	/**
+	 * Get a boolean indicating wether or not the end of the sequence has been reached.
+	 */
+	bool done() { return _done; }
+
+	size_t write(uint8_t c);
+	using Print::write;
+};
+
+/**
+ * Parses every sequence written to it, handing each fix over to a callback as soon as its new line is received.
+ * Meant to be registered as the output of the +UGNSINF unsolicited result code, see SIM808::startGpsStream.
+ */
+class SIM808GnssStream : public SIM808GnssParser
+{
+private:
+	SIM808GnssFix _fix;
+	SIM808GnssFixCallback _callback;
+
+public:
+	SIM808GnssStream(SIM808GnssFixCallback callback);
+
+	size_t write(uint8_t c);
+	using Print::write;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SIMComAT.h"
+
+/**
+ * GPRS commands shared by SIM808, its TCP/IP commands and SIM808ConnectionManager.
+ */
+
+TOKEN_TEXT(CGREG, "+CGREG");
+TOKEN_TEXT(CGATT, "+CGATT");
+TOKEN_TEXT(SAPBR, "+SAPBR");
+TOKEN_TEXT(SHUT_OK, "SHUT OK");
+
+AT_COMMAND_SPEC(NETWORK_REGISTRATION_READ, "+CGREG?", TOKEN_CGREG, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(GPRS_ATTACH, "+CGATT=", NULL, 10000);
+AT_COMMAND_SPEC(GPRS_ATTACH_READ, "+CGATT?", TOKEN_CGATT, 10000);
+AT_COMMAND_SPEC(BEARER, "+SAPBR=", NULL, 65000);
+AT_COMMAND_SPEC(BEARER_STATUS, "+SAPBR=", TOKEN_SAPBR, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(SHUTDOWN_CONNECTIONS, "+CIPSHUT", TOKEN_SHUT_OK, 65000);
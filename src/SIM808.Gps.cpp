@@ -2,6 +2,41 @@
 
 TOKEN_TEXT(GPS_POWER, "+CGNSPWR");
 TOKEN_TEXT(GPS_INFO, "+CGNSINF");
+TOKEN_TEXT(GPS_URC, "+CGNSURC");
+TOKEN_TEXT(GPS_URC_INFO, "+UGNSINF: ");
+TOKEN_TEXT(CIPGSMLOC, "+CIPGSMLOC");
+
+AT_COMMAND_SPEC(CELL_LOCATION, "+CIPGSMLOC=", TOKEN_CIPGSMLOC, 60000);
+AT_COMMAND_SPEC(GPS_POWER_READ, "+CGNSPWR?", TOKEN_GPS_POWER, 10000);
+
+#define CELL_LOCATION_FIELD_LONGITUDE 1
+#define CELL_LOCATION_FIELD_LATITUDE 2
+#define CELL_LOCATION_FIELD_DATE 3
+#define CELL_LOCATION_FIELD_TIME 4
+
+/**
+ * Parse a decimal number into an integer scaled by 10^decimals, with fixed point arithmetic only.
+ */
+static int32_t parseFixedPoint(const char* str, uint8_t decimals)
+{
+	bool negative = *str == '-';
+	int8_t read = -1;	// decimals read, -1 before the decimal point
+	int32_t value = 0;
+
+	if(negative) str++;
+
+	for(; (*str >= '0' && *str <= '9') || *str == '.'; str++) {
+		if(*str == '.') read = 0;
+		else if(read < (int8_t)decimals) {
+			value = value * 10 + (*str - '0');
+			if(read >= 0) read++;
+		}
+	}
+
+	for(int8_t i = read < 0 ? 0 : read; i < decimals; i++) value *= 10;
+
+	return negative ? -value : value;
+}
 
 bool SIM808::powerOnOffGps(bool power)
 {
@@ -21,6 +56,8 @@ bool SIM808::getGpsPosition(char *response, size_t responseSize)
 
 	// GPSINF response might be too long for the reply buffer
 	copyCurrentLine(response, responseSize, strlen_P(TOKEN_GPS_INFO) + 2);
+
+	return waitResponse() == 0;
 }
 
 void SIM808::getGpsField(const char* response, SIM808GpsField field, char** result) 
@@ -78,13 +115,104 @@ SIM808GpsStatus SIM808::getGpsStatus(char * response, size_t responseSize, uint8
 	return result;
 }
 
+SIM808GpsStatus SIM808::getGpsFix(SIM808GnssFix* fix, uint8_t minSatellitesForAccurateFix)
+{
+	SIM808GnssParser parser;
+
+	sendAT(TO_F(TOKEN_GPS_INFO));
+
+	if(waitResponse(TO_F(TOKEN_GPS_INFO)) != 0)
+		return SIM808GpsStatus::Fail;
+
+	parser.begin(fix);
+	parser.print(replyBuffer + strlen_P(TOKEN_GPS_INFO) + 2);
+	// the sequence might be too long for the reply buffer, parsing the rest as it comes
+	if(!parser.done()) readNext(parser, SIZE_MAX, SIMCOMAT_DEFAULT_TIMEOUT, '\n');
+
+	if(!parser.done() || waitResponse() != 0) return SIM808GpsStatus::Fail;
+
+	if(!fix->runStatus) return SIM808GpsStatus::Off;
+	if(!fix->fixStatus) return SIM808GpsStatus::NoFix;
+
+	return fix->gnssUsed > minSatellitesForAccurateFix ?
+		SIM808GpsStatus::AccurateFix :
+		SIM808GpsStatus::Fix;
+}
+
+bool SIM808::parseGpsFix(const char* response, SIM808GnssFix* fix)
+{
+	SIM808GnssParser parser;
+
+	parser.begin(fix);
+	parser.print(response);
+	parser.write('\n'); // copied sequences do not have their new line anymore
+
+	return fix->runStatus == 1;
+}
+
+bool SIM808::getCellLocation(SIM808GnssFix* fix)
+{
+	uint16_t locationCode;
+	bool located;
+	char* field;
+
+	memset(fix, 0, sizeof(SIM808GnssFix));
+
+	sendCommandAT(AT_CELL_LOCATION, 1, 1);												//AT+CIPGSMLOC=1,1
+	// +CIPGSMLOC: <code>[,<longitude>,<latitude>,<yyyy/MM/dd>,<hh:mm:ss>]
+	if(waitResponse(AT_CELL_LOCATION) != 0 ||
+		!parseReply(',', 0, &locationCode))
+		return false;
+
+	located = locationCode == 0 && (field = find(replyBuffer, ',', CELL_LOCATION_FIELD_TIME)) != NULL;
+	if(located) {
+		fix->hour = atoi(field);
+		fix->minute = atoi(field + 3);
+		fix->second = atoi(field + 6);
+
+		field = find(replyBuffer, ',', CELL_LOCATION_FIELD_DATE);
+		fix->year = atoi(field);
+		fix->month = atoi(field + 5);
+		fix->day = atoi(field + 8);
+
+		fix->longitude = parseFixedPoint(find(replyBuffer, ',', CELL_LOCATION_FIELD_LONGITUDE), 6);
+		fix->latitude = parseFixedPoint(find(replyBuffer, ',', CELL_LOCATION_FIELD_LATITUDE), 6);
+	}
+
+	return waitResponse() == 0 && located;
+}
+
+bool SIM808::startGpsStream(SIM808GnssStream& stream, uint8_t period)
+{
+	powerOnOffGps(true);
+
+	unregisterUrcHandler(TO_F(TOKEN_GPS_URC_INFO));
+	if(!registerUrcHandler(TO_F(TOKEN_GPS_URC_INFO), stream)) return false;
+
+	sendAT(TO_F(TOKEN_GPS_URC), TO_F(TOKEN_WRITE), period);
+	if(waitResponse() == 0) return true;
+
+	unregisterUrcHandler(TO_F(TOKEN_GPS_URC_INFO));
+	return false;
+}
+
+bool SIM808::stopGpsStream()
+{
+	sendAT(TO_F(TOKEN_GPS_URC), TO_F(TOKEN_WRITE), (uint8_t)0);
+	bool result = waitResponse() == 0;
+
+	// sequences already on their way are not handed over anymore
+	unregisterUrcHandler(TO_F(TOKEN_GPS_URC_INFO));
+	return result;
+}
+
 bool SIM808::getGpsPowerState(bool *state)
 {
 	uint8_t result;
 
-	sendAT(TO_F(TOKEN_GPS_POWER), TO_F(TOKEN_READ));
+	sendCommandAT(AT_GPS_POWER_READ);															//AT+CGNSPWR?
 
-	if(waitResponse(10000L, TO_F(TOKEN_GPS_POWER)) != 0 ||
+	if(waitResponse(AT_GPS_POWER_READ) != 0 ||
 		!parseReply(',', 0, &result) ||
 		waitResponse())
 		return false;
@@ -1,22 +1,27 @@
 #include "SIM808.h"
 
-AT_COMMAND(SEND_SMS, "+CMGS=\"%s\"");
-
 TOKEN_TEXT(CPIN, "+CPIN");
 TOKEN_TEXT(CSQ, "+CSQ");
 TOKEN_TEXT(CMGS, "+CMGS");
+TOKEN_TEXT(PROMPT, ">");
+
+AT_COMMAND_SPEC(SIM_UNLOCK, "+CPIN=", NULL, 5000);
+AT_COMMAND_SPEC(SIM_STATE, "+CPIN?", TOKEN_CPIN, 5000);
+AT_COMMAND_SPEC(SIGNAL_QUALITY, "+CSQ", TOKEN_CSQ, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(SMS_MESSAGE_FORMAT, "+CMGF=", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(SEND_SMS, "+CMGS=", TOKEN_CMGS, 60000);
 
 bool SIM808::simUnlock(const char* pin)
 {
-	sendAT(TO_F(TOKEN_CPIN), TO_F(TOKEN_WRITE), pin);
+	sendCommandAT(AT_SIM_UNLOCK, pin);
 
-	return waitResponse(5000L) == 0;
+	return waitResponse(AT_SIM_UNLOCK) == 0;
 }
 
 size_t SIM808::getSimState(char *state, size_t stateSize)
 {
-	sendAT(TO_F(TOKEN_CPIN), TO_F(TOKEN_READ));
-	if(waitResponse(5000L, TO_F(TOKEN_CPIN)) != 0) return 0;
+	sendCommandAT(AT_SIM_STATE);
+	if(waitResponse(AT_SIM_STATE) != 0) return 0;
 
 	copyCurrentLine(state, stateSize, strlen_P(TOKEN_CPIN) + 2);
 
@@ -49,10 +54,10 @@ SIM808SignalQualityReport SIM808::getSignalQuality()
 
 	SIM808SignalQualityReport report = {99, 99, 1};
 
-	sendAT(TO_F(TOKEN_CSQ));
-	if(waitResponse(TO_F(TOKEN_CSQ)) != 0 ||
-		!parseReply(',', (uint8_t)SIM808SignalQualityResponse::SignalStrength, &quality) ||
-		!parseReply(',', (uint8_t)SIM808SignalQualityResponse::BitErrorrate, &errorRate) ||
+	sendCommandAT(AT_SIGNAL_QUALITY);
+	// +CSQ: <rssi>,<ber>
+	if(waitResponse(AT_SIGNAL_QUALITY) != 0 ||
+		!parseReplyFields(',', &quality, &errorRate) ||
 		waitResponse())
 		return report;
 
@@ -70,21 +75,21 @@ SIM808SignalQualityReport SIM808::getSignalQuality()
 
 bool SIM808::setSmsMessageFormat(SIM808SmsMessageFormat format)
 {
-	sendAT(S_F("+CMGF="), (uint8_t)format);
-	return waitResponse() == 0;
+	sendCommandAT(AT_SMS_MESSAGE_FORMAT, (uint8_t)format);
+	return waitResponse(AT_SMS_MESSAGE_FORMAT) == 0;
 }
 
 bool SIM808::sendSms(const char *addr, const char *msg)
 {
 	if (!setSmsMessageFormat(SIM808SmsMessageFormat::Text)) return false;
-	sendFormatAT(TO_F(AT_COMMAND_SEND_SMS), addr);
+	sendCommandAT(AT_SEND_SMS, addr);
 
-	if (!waitResponse(S_F(">")) == 0) return false;
+	if (waitResponse(TO_F(TOKEN_PROMPT)) != 0) return false;
 
 	SENDARROW;
 	print(msg);
 	print((char)0x1A);
 
-	return waitResponse(60000L, TO_F(TOKEN_CMGS)) == 0 &&
+	return waitResponse(AT_SEND_SMS) == 0 &&
 		waitResponse() == 0;
 }
\ No newline at end of file
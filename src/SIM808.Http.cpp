@@ -3,8 +3,8 @@
 AT_COMMAND(SET_HTTP_PARAMETER_STRING, "+HTTPPARA=\"%S\",\"%s\"");
 AT_COMMAND(SET_HTTP_PARAMETER_STRING_PROGMEM, "+HTTPPARA=\"%S\",\"%S\"");
 AT_COMMAND(SET_HTTP_PARAMETER_INT, "+HTTPPARA=\"%S\",\"%d\"");
-AT_COMMAND(HTTP_DATA, "+HTTPDATA=%d,%d");
 AT_COMMAND(HTTP_READ, "+HTTPREAD=%d,%d");
+AT_COMMAND(HTTP_READ_WINDOW, "+HTTPREAD=%l,%d");
 
 TOKEN_TEXT(HTTP_DATA, "+HTTPDATA");
 TOKEN_TEXT(HTTP_ACTION, "+HTTPACTION");
@@ -14,6 +14,8 @@ TOKEN_TEXT(HTTP_SSL, "+HTTPSSL");
 TOKEN_TEXT(HTTP_TERM, "+HTTPTERM");
 TOKEN(DOWNLOAD);
 
+AT_COMMAND_SPEC(HTTP_BODY, "+HTTPDATA=", TOKEN_DOWNLOAD, 10000);	///< The timeout is given to the device to receive a body held in memory.
+
 AT_COMMAND_PARAMETER(HTTP, CONTENT);
 AT_COMMAND_PARAMETER(HTTP, REDIR);
 AT_COMMAND_PARAMETER(HTTP, CID);
@@ -21,34 +23,31 @@ AT_COMMAND_PARAMETER(HTTP, URL);
 AT_COMMAND_PARAMETER(HTTP, UA);
 
 
-bool SIM808::setHttpParameter(ATConstStr parameter, ATConstStr value)
+bool SIM808::batchHttpParameter(ATConstStr parameter, ATConstStr value)
 {
-	sendFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_STRING_PROGMEM), parameter, value);
-	return waitResponse() == 0;
+	return batchFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_STRING_PROGMEM), parameter, value);
 }
 
 #if defined(__AVR__)
 
-bool SIM808::setHttpParameter(ATConstStr parameter, const char * value)
+bool SIM808::batchHttpParameter(ATConstStr parameter, const char * value)
 {
-	sendFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_STRING), parameter, value);
-	return waitResponse() == 0;
+	return batchFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_STRING), parameter, value);
 }
 
 #endif
 
-bool SIM808::setHttpParameter(ATConstStr parameter, uint8_t value)
+bool SIM808::batchHttpParameter(ATConstStr parameter, uint8_t value)
 {
-	sendFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_INT), parameter, value);
-	return waitResponse() == 0;
+	return batchFormatAT(TO_F(AT_COMMAND_SET_HTTP_PARAMETER_INT), parameter, value);
 }
 
 uint16_t SIM808::httpGet(const char *url, char *response, size_t responseSize)
 {
 	uint16_t statusCode = 0;
-	size_t dataSize = 0;
+	ATDataSize dataSize = 0;
 
-	bool result = setupHttpRequest(url) &&
+	setupHttpRequest(url) &&
 		fireHttpRequest(SIM808HttpAction::Get, &statusCode, &dataSize) &&
 		readHttpResponse(response, responseSize, dataSize) &&
 		httpEnd();
@@ -56,13 +55,25 @@ uint16_t SIM808::httpGet(const char *url, char *response, size_t responseSize)
 	return statusCode;
 }
 
+uint16_t SIM808::httpGet(const char *url, Print& response, SIM808HttpTransferReport* report)
+{
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	setupHttpRequest(url) &&
+		fireHttpRequest(SIM808HttpAction::Get, &statusCode, &dataSize) &&
+		readHttpResponse(response, dataSize, report) &&
+		httpEnd();
+
+	return statusCode;
+}
+
 uint16_t SIM808::httpPost(const char *url, ATConstStr contentType, const char *body, char *response, size_t responseSize)
 {
 	uint16_t statusCode = 0;
-	size_t dataSize = 0;
+	ATDataSize dataSize = 0;
 
-	bool result = setupHttpRequest(url) &&
-		setHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_CONTENT), contentType) &&
+	setupHttpRequest(url, contentType) &&
 		setHttpBody(body) &&
 		fireHttpRequest(SIM808HttpAction::Post, &statusCode, &dataSize) &&
 		readHttpResponse(response, responseSize, dataSize) &&
@@ -71,16 +82,61 @@ uint16_t SIM808::httpPost(const char *url, ATConstStr contentType, const char *b
 	return statusCode;
 }
 
-bool SIM808::setupHttpRequest(const char* url)
+uint16_t SIM808::httpPost(const char *url, ATConstStr contentType, Stream& body, ATDataSize bodySize, char *response, size_t responseSize)
 {
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	setupHttpRequest(url, contentType) &&
+		setHttpBody(body, bodySize) &&
+		fireHttpRequest(SIM808HttpAction::Post, &statusCode, &dataSize) &&
+		readHttpResponse(response, responseSize, dataSize) &&
+		httpEnd();
+
+	return statusCode;
+}
+
+uint16_t SIM808::httpPost(const char *url, ATConstStr contentType, SIM808HttpBodyProducer producer, ATDataSize bodySize, char *response, size_t responseSize)
+{
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	setupHttpRequest(url, contentType) &&
+		setHttpBody(producer, bodySize) &&
+		fireHttpRequest(SIM808HttpAction::Post, &statusCode, &dataSize) &&
+		readHttpResponse(response, responseSize, dataSize) &&
+		httpEnd();
+
+	return statusCode;
+}
+
+bool SIM808::setupHttpRequest(const char* url, ATConstStr contentType)
+{
+	uint8_t parameters = HttpAll;
+
+	// the service starts with SSL disabled
+	if(url[4] != 's') parameters &= ~HttpSsl;
+
+	// HTTPTERM fails when the service is not started yet, and would fail the whole batch
 	httpEnd();
+	return sendHttpParameters(url, contentType, parameters);
+}
+
+bool SIM808::sendHttpParameters(const char* url, ATConstStr contentType, uint8_t parameters)
+{
+	beginBatch();
+	if(parameters & HttpService) {
+		batchAT(TO_F(TOKEN_HTTP_INIT));
+		batchHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_REDIR), 1);
+		batchHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_CID), 1);
+	}
+
+	if(parameters & HttpUrl) batchHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_URL), url);
+	if(parameters & HttpSsl) batchAT(TO_F(TOKEN_HTTP_SSL), TO_F(TOKEN_WRITE), (uint8_t)(url[4] == 's'));
+	if((parameters & HttpUserAgent) && _userAgent != NULL) batchHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_UA), _userAgent);
+	if((parameters & HttpContentType) && contentType != NULL) batchHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_CONTENT), contentType);
 
-	return httpInit() &&
-		setHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_REDIR), 1) &&
-		setHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_CID), 1) &&
-		setHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_URL), url) &&
-		(url[4] != 's' || (sendAT(TO_F(TOKEN_HTTP_SSL), TO_F(TOKEN_WRITE), 1), waitResponse() == 0)) &&
-		(_userAgent == NULL || setHttpParameter(TO_F(AT_COMMAND_PARAMETER_HTTP_UA), _userAgent));
+	return endBatch();
 }
 
 bool SIM808::httpInit()
@@ -90,38 +146,134 @@ bool SIM808::httpInit()
 
 bool SIM808::httpEnd()
 {
+	_httpService++;
 	return (sendAT(TO_F(TOKEN_HTTP_TERM)), waitResponse() == 0);
 }
 
-bool SIM808::setHttpBody(const char* body)
+bool SIM808::beginHttpBody(ATDataSize bodySize, uint32_t timeout)
 {
-	sendFormatAT(TO_F(AT_COMMAND_HTTP_DATA), strlen(body), 10000L);
-	
-	if(waitResponse(TO_F(TOKEN_DOWNLOAD)) != 0) return false;		
+	sendCommandAT(AT_HTTP_BODY, (long)bodySize, (long)timeout);								//AT+HTTPDATA=size,timeout
+	if(waitResponse(TO_F(AT_HTTP_BODY.response)) != 0) return false;
 
 	SENDARROW;
+	return true;
+}
+
+void SIM808::abortHttpBody(ATDataSize remaining)
+{
+	uint8_t padding[HTTP_WRITE_CHUNK_SIZE];
+	memset(padding, 0, sizeof(padding));
+
+	while(remaining) {
+		size_t paddingSize = min(remaining, (ATDataSize)HTTP_WRITE_CHUNK_SIZE);
+
+		write(padding, paddingSize);
+		remaining -= paddingSize;
+	}
+
+	// the request is not fired, the padded body is never sent
+	waitResponse();
+}
+
+bool SIM808::setHttpBody(const char* body)
+{
+	if(!beginHttpBody(strlen(body), AT_HTTP_BODY.timeout)) return false;
+
 	print(body);
 
 	if(waitResponse() != 0) return false;
 	return true;
 }
 
-bool SIM808::fireHttpRequest(const SIM808HttpAction action, uint16_t *statusCode, size_t *dataSize)
+bool SIM808::setHttpBody(Stream& body, ATDataSize bodySize)
+{
+	uint8_t chunk[HTTP_WRITE_CHUNK_SIZE];
+	ATDataSize offset = 0;
+
+	if(!beginHttpBody(bodySize, HTTP_BODY_TIMEOUT)) return false;
+
+	while(offset < bodySize) {
+		size_t chunkSize = body.readBytes(chunk, min(bodySize - offset, (ATDataSize)HTTP_WRITE_CHUNK_SIZE));
+		if(!chunkSize) {
+			abortHttpBody(bodySize - offset);
+			return false;
+		}
+
+		write(chunk, chunkSize);
+		offset += chunkSize;
+	}
+
+	return waitResponse() == 0;
+}
+
+bool SIM808::setHttpBody(SIM808HttpBodyProducer producer, ATDataSize bodySize)
+{
+	uint8_t chunk[HTTP_WRITE_CHUNK_SIZE];
+	ATDataSize offset = 0;
+
+	if(!beginHttpBody(bodySize, HTTP_BODY_TIMEOUT)) return false;
+
+	while(offset < bodySize) {
+		size_t chunkSize = producer(chunk, min(bodySize - offset, (ATDataSize)HTTP_WRITE_CHUNK_SIZE), offset);
+		if(!chunkSize) {
+			abortHttpBody(bodySize - offset);
+			return false;
+		}
+
+		write(chunk, chunkSize);
+		offset += chunkSize;
+	}
+
+	return waitResponse() == 0;
+}
+
+bool SIM808::fireHttpRequest(const SIM808HttpAction action, uint16_t *statusCode, ATDataSize *dataSize)
 {
 	sendAT(TO_F(TOKEN_HTTP_ACTION), TO_F(TOKEN_WRITE), (uint8_t)action);
 
+	// +HTTPACTION: <method>,<status code>,<data length>
 	return waitResponse(HTTP_TIMEOUT, TO_F(TOKEN_HTTP_ACTION)) == 0 &&
-		parseReply(',', (uint8_t)SIM808HttpActionResponse::StatusCode, statusCode) &&
-		parseReply(',', (uint8_t)SIM808HttpActionResponse::DataLen, dataSize);
+		parseReplyFields(',', (uint8_t*)NULL, statusCode, dataSize);
 }
 
-bool SIM808::readHttpResponse(char *response, size_t responseSize, size_t dataSize)
+bool SIM808::readHttpResponse(char *response, size_t responseSize, ATDataSize dataSize)
 {
-	size_t readSize = min(responseSize - 1, dataSize);
+	size_t readSize = min((ATDataSize)(responseSize - 1), dataSize);
 
-	sendFormatAT(TO_F(AT_COMMAND_HTTP_READ), 0, readSize);
+	sendFormatAT(TO_F(AT_COMMAND_HTTP_READ), 0, (int)readSize);
 	if(waitResponse(TO_F(TOKEN_HTTP_READ)) != 0) return false;
 
 	readNext(response, readSize + 1); // taking in account the string term
 	return waitResponse() == 0;
 }
+
+bool SIM808::readHttpResponse(Print& response, ATDataSize dataSize, SIM808HttpTransferReport* report)
+{
+	ATDataSize offset = 0;
+	uint32_t start = millis();
+
+	while(offset < dataSize) {
+		size_t windowSize = min(dataSize - offset, (ATDataSize)HTTP_READ_CHUNK_SIZE);
+
+		sendFormatAT(TO_F(AT_COMMAND_HTTP_READ_WINDOW), (long)offset, (int)windowSize);
+		if(waitResponse(TO_F(TOKEN_HTTP_READ)) != 0 ||
+			!parseReply(',', 0, &windowSize)) break;
+
+		// the window directly follows the +HTTPREAD line
+		size_t readSize = readNext(response, windowSize, SIMCOMAT_DEFAULT_TIMEOUT);
+		offset += readSize;
+
+		if(readSize != windowSize || waitResponse() != 0) break;
+	}
+
+	if(report) {
+		report->size = dataSize;
+		report->transferred = offset;
+		report->duration = millis() - start;
+		report->throughput = report->duration ?
+			offset / report->duration * 1000 + offset % report->duration * 1000 / report->duration :
+			offset;
+	}
+
+	return offset == dataSize;
+}
@@ -0,0 +1,83 @@
+#include "SIM808.h"
+
+SIM808HttpSession::SIM808HttpSession(SIM808& sim808)
+{
+	_sim808 = &sim808;
+	_ready = false;
+}
+
+bool SIM808HttpSession::prepare(const char* url, ATConstStr contentType)
+{
+	bool fresh = !_ready || _service != _sim808->_httpService;
+	bool ssl = url[4] == 's';
+	uint8_t parameters = SIM808::HttpUrl | SIM808::HttpSsl | SIM808::HttpUserAgent | SIM808::HttpContentType;
+
+	if(fresh) _ready = _sim808->setupHttpRequest(url, contentType);
+	else {
+		if(_url[0] && !strcmp(url, _url)) parameters &= ~SIM808::HttpUrl;
+		if(ssl == _ssl) parameters &= ~SIM808::HttpSsl;
+		if(_sim808->_userAgent == _userAgent) parameters &= ~SIM808::HttpUserAgent;
+		if(contentType == _contentType) parameters &= ~SIM808::HttpContentType;
+
+		_ready = _sim808->sendHttpParameters(url, contentType, parameters);
+	}
+
+	if(!_ready) return false;
+
+	if(fresh) {
+		_service = _sim808->_httpService;
+		_contentType = NULL;
+	}
+
+	_ssl = ssl;
+	if(strlcpy(_url, url, sizeof(_url)) >= sizeof(_url)) _url[0] = '\0';
+	_userAgent = _sim808->_userAgent;
+	if(contentType != NULL) _contentType = contentType;
+
+	return true;
+}
+
+uint16_t SIM808HttpSession::get(const char* url, char* response, size_t responseSize)
+{
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	if(!prepare(url, NULL)) return statusCode;
+
+	_ready = _sim808->fireHttpRequest(SIM808HttpAction::Get, &statusCode, &dataSize);
+	if(_ready) _sim808->readHttpResponse(response, responseSize, dataSize);
+
+	return statusCode;
+}
+
+uint16_t SIM808HttpSession::get(const char* url, Print& response, SIM808HttpTransferReport* report)
+{
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	if(!prepare(url, NULL)) return statusCode;
+
+	_ready = _sim808->fireHttpRequest(SIM808HttpAction::Get, &statusCode, &dataSize);
+	if(_ready) _sim808->readHttpResponse(response, dataSize, report);
+
+	return statusCode;
+}
+
+uint16_t SIM808HttpSession::post(const char* url, ATConstStr contentType, const char* body, char* response, size_t responseSize)
+{
+	uint16_t statusCode = 0;
+	ATDataSize dataSize = 0;
+
+	if(!prepare(url, contentType) || !_sim808->setHttpBody(body)) return statusCode;
+
+	_ready = _sim808->fireHttpRequest(SIM808HttpAction::Post, &statusCode, &dataSize);
+	if(_ready) _sim808->readHttpResponse(response, responseSize, dataSize);
+
+	return statusCode;
+}
+
+bool SIM808HttpSession::end()
+{
+	_ready = false;
+	return _sim808->httpEnd();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIMComAT.Common.h"
+#include "SIM808.Types.h"
+
+class SIM808;
+
+#define SIM808_HTTP_SESSION_URL_SIZE 64	///< Longest URL remembered by a session, longer ones are sent again on each request.
+
+/**
+ * Keeps the HTTP service of the device up between requests, and only sends
+ * the HTTP parameters that changed since the previous request.
+ * Repeated requests to the same URL only cost HTTPDATA, HTTPACTION and HTTPREAD.
+ * The URL is compared to a copy of the previous one. The user agent and content type,
+ * constant strings, are compared by address.
+ * 
+ * Any one-shot request made with SIM808::httpGet or SIM808::httpPost in between restarts
+ * the HTTP service, in which case the session transparently sets everything up again.
+ */
+class SIM808HttpSession
+{
+private:
+	SIM808* _sim808;
+	bool _ready;
+	uint8_t _service;		///< HTTP service instance the cached values below are valid for.
+	bool _ssl;
+	char _url[SIM808_HTTP_SESSION_URL_SIZE];	///< Empty if the previous URL did not fit.
+	const char* _userAgent;
+	ATConstStr _contentType;
+
+	/**
+	 * (Re)initialize the HTTP service if needed, and send the parameters that changed.
+	 * The content type is left untouched if NULL.
+	 */
+	bool prepare(const char* url, ATConstStr contentType);
+
+public:
+	SIM808HttpSession(SIM808& sim808);
+
+	/**
+	 * Send an HTTP GET request and read the server response within the limit of responseSize.
+	 */
+	uint16_t get(const char* url, char* response, size_t responseSize);
+	/**
+	 * Send an HTTP GET request and stream the whole server response to response. See SIM808::httpGet.
+	 */
+	uint16_t get(const char* url, Print& response, SIM808HttpTransferReport* report = NULL);
+	/**
+	 * Send an HTTP POST request and read the server response within the limit of responseSize.
+	 */
+	uint16_t post(const char* url, ATConstStr contentType, const char* body, char* response, size_t responseSize);
+	/**
+	 * Terminate the HTTP service.
+	 */
+	bool end();
+};
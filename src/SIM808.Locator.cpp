@@ -0,0 +1,35 @@
+#include "SIM808.h"
+
+SIM808Locator::SIM808Locator(SIM808& sim808, uint8_t minSatellitesForAccurateFix)
+{
+	_sim808 = &sim808;
+	_source = SIM808LocationSource::None;
+	_minSatellitesForAccurateFix = minSatellitesForAccurateFix;
+}
+
+SIM808LocationSource SIM808Locator::begin()
+{
+	_source = SIM808LocationSource::None;
+	_sim808->powerOnOffGps(true);
+
+	return update();
+}
+
+SIM808LocationSource SIM808Locator::update()
+{
+	SIM808GnssFix fix;
+	SIM808GpsStatus status = _sim808->getGpsFix(&fix, _minSatellitesForAccurateFix);
+
+	if(status == SIM808GpsStatus::AccurateFix || status == SIM808GpsStatus::Fix) {
+		_fix = fix;
+		_source = status == SIM808GpsStatus::AccurateFix ?
+			SIM808LocationSource::AccurateGnss :
+			SIM808LocationSource::Gnss;
+	}
+	else if(_source == SIM808LocationSource::None && _sim808->getCellLocation(&fix)) {
+		_fix = fix;
+		_source = SIM808LocationSource::Cell;
+	}
+
+	return _source;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIM808.Types.h"
+
+class SIM808;
+
+/**
+ * Provides a position as soon as possible : a coarse one from the network first,
+ * upgraded to a GPS fix once one is acquired.
+ * The network position requires the GPRS bearer to be open, see SIM808::getCellLocation.
+ */
+class SIM808Locator
+{
+private:
+	SIM808* _sim808;
+	SIM808GnssFix _fix;
+	SIM808LocationSource _source;
+	uint8_t _minSatellitesForAccurateFix;
+
+public:
+	SIM808Locator(SIM808& sim808, uint8_t minSatellitesForAccurateFix = GPS_ACCURATE_FIX_MIN_SATELLITES);
+
+	/**
+	 * Power GPS on, and get a first position from the network.
+	 * Returns the source of the position held, None if the network could not provide one.
+	 */
+	SIM808LocationSource begin();
+	/**
+	 * Read the current GPS fix and keep it if one is acquired, otherwise keep the position held,
+	 * asking the network again if it has not provided one yet.
+	 * Returns the source of the position held.
+	 */
+	SIM808LocationSource update();
+
+	/**
+	 * Get the position held. Only valid when source() is not None.
+	 */
+	const SIM808GnssFix& location() { return _fix; }
+	SIM808LocationSource source() { return _source; }
+};
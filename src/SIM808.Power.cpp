@@ -3,6 +3,28 @@
 TOKEN_TEXT(CBC, "+CBC");
 TOKEN_TEXT(CFUN, "+CFUN");
 
+AT_COMMAND_SPEC(CHARGING_STATE, "+CBC", TOKEN_CBC, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(PHONE_FUNCTIONALITY, "+CFUN=", NULL, 10000);
+AT_COMMAND_SPEC(PHONE_FUNCTIONALITY_READ, "+CFUN?", TOKEN_CFUN, 10000);
+AT_COMMAND_SPEC(SLOW_CLOCK, "+CSCLK=", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+
+TOKEN(RDY);
+TOKEN_TEXT(FUNCTIONALITY_READY, "+CFUN: 1");
+TOKEN_TEXT(SIM_READY, "+CPIN: READY");
+TOKEN_TEXT(CALL_READY, "Call Ready");
+TOKEN_TEXT(SMS_READY, "SMS Ready");
+
+/**
+ * Unsolicited lines announcing each boot phase, indexed by SIM808BootPhase.
+ */
+const char* const BOOT_TOKENS[SIM808_BOOT_PHASES] S_PROGMEM = {
+	TOKEN_RDY,
+	TOKEN_FUNCTIONALITY_READY,
+	TOKEN_SIM_READY,
+	TOKEN_CALL_READY,
+	TOKEN_SMS_READY
+};
+
 bool SIM808::powered()
 {
 	if(_statusPin == SIM808_UNAVAILABLE_PIN) {
@@ -22,34 +44,81 @@ bool SIM808::powerOnOff(bool power)
 	
 	SIM808_PRINT_P("powerOnOff: %t", power);
 
+	bool statusPin = _statusPin != SIM808_UNAVAILABLE_PIN;
+	uint16_t interval = statusPin ? SIM808_STATUS_POLL_INTERVAL : SIM808_AT_POLL_INTERVAL;
+	uint32_t start = millis();
+
 	digitalWrite(_pwrKeyPin, LOW);
-	delay(2000);
+	// the key is released as soon as the status pin reports the new state
+	do {
+		delay(SIM808_STATUS_POLL_INTERVAL);
+	} while(millis() - start < SIM808_PWRKEY_PULSE &&
+		!(statusPin && millis() - start >= SIM808_PWRKEY_MIN_PULSE && digitalRead(_statusPin) == power));
 	digitalWrite(_pwrKeyPin, HIGH);
 
-	int16_t timeout = 2000;
-	do {
-		delay(150);
-		timeout -= 150;
-		currentlyPowered = powered();
-	} while(currentlyPowered != power && timeout > 0);
+	if(power) {
+		beginBoot(start);
+		// listening to the device instead of polling it with commands
+		if(!statusPin && waitForBoot(SIM808BootPhase::Rdy, SIM808_POWER_TIMEOUT)) return true;
+	}
+
+	start = millis();
+	while((currentlyPowered = powered()) != power && millis() - start < SIM808_POWER_TIMEOUT) delay(interval);
 
 	return currentlyPowered == power;
 }
 
+void SIM808::beginBoot(uint32_t start)
+{
+	_bootStart = start;
+	_bootPhases = 0;
+	memset(&_bootTimings, 0, sizeof(_bootTimings));
+}
+
+bool SIM808::bootLine(const char* line)
+{
+	for(uint8_t i = 0; i < SIM808_BOOT_PHASES; i++) {
+		if(strcmp_P(line, (const char*)pgm_read_ptr(&BOOT_TOKENS[i]))) continue;
+
+		if(!(_bootPhases & (1 << i))) {
+			_bootPhases |= 1 << i;
+			_bootTimings.phases[i] = millis() - _bootStart;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+bool SIM808::waitForBoot(SIM808BootPhase phase, uint16_t timeout)
+{
+	uint8_t wanted = (1 << ((uint8_t)phase + 1)) - 1;
+	uint32_t start = millis();
+
+	while((_bootPhases & wanted) != wanted) {
+		if(millis() - start >= timeout) return false;
+
+		poll();
+		yield();
+	}
+
+	return true;
+}
+
 SIM808ChargingStatus SIM808::getChargingState()
 {
 	uint8_t state;
 	uint8_t level;
 	uint16_t voltage;
 
-	sendAT(TO_F(TOKEN_CBC));
+	sendCommandAT(AT_CHARGING_STATE);
 
-	if (waitResponse(TO_F(TOKEN_CBC)) == 0 &&
-		parseReply(',', (uint8_t)SIM808BatteryChargeField::Bcs, &state) &&
-		parseReply(',', (uint8_t)SIM808BatteryChargeField::Bcl, &level) &&
-		parseReply(',', (uint16_t)SIM808BatteryChargeField::Voltage, &voltage) &&
+	// +CBC: <bcs>,<bcl>,<voltage>
+	if (waitResponse(AT_CHARGING_STATE) == 0 &&
+		parseReplyFields(',', &state, &level, &voltage) &&
 		waitResponse() == 0)
-		return { (SIM808ChargingState)state, level, voltage };
+		return { (SIM808ChargingState)state, (int8_t)level, (int16_t)voltage };
 			
 	return { SIM808ChargingState::Error, 0, 0 };
 }
@@ -58,9 +127,9 @@ SIM808PhoneFunctionality SIM808::getPhoneFunctionality()
 {
 	uint8_t state;
 
-	sendAT(TO_F(TOKEN_CFUN), TO_F(TOKEN_READ));
+	sendCommandAT(AT_PHONE_FUNCTIONALITY_READ);
 
-	if (waitResponse(10000L, TO_F(TOKEN_CFUN)) == 0 &&
+	if (waitResponse(AT_PHONE_FUNCTIONALITY_READ) == 0 &&
 		parseReply(',', 0, &state) &&
 		waitResponse() == 0)
 		return (SIM808PhoneFunctionality)state;
@@ -70,15 +139,15 @@ SIM808PhoneFunctionality SIM808::getPhoneFunctionality()
 
 bool SIM808::setPhoneFunctionality(SIM808PhoneFunctionality fun)
 {
-	sendAT(TO_F(TOKEN_CFUN), TO_F(TOKEN_WRITE), (uint8_t)fun);
+	sendCommandAT(AT_PHONE_FUNCTIONALITY, (int8_t)fun);
 
-	return waitResponse(10000L) == 0;
+	return waitResponse(AT_PHONE_FUNCTIONALITY) == 0;
 }
 
 bool SIM808::setSlowClock(SIM808SlowClock mode)
 {
-	sendAT(S_F("+CSCLK"), TO_F(TOKEN_WRITE), (uint8_t)mode);
+	sendCommandAT(AT_SLOW_CLOCK, (uint8_t)mode);
 
-	return waitResponse() == 0;
+	return waitResponse(AT_SLOW_CLOCK) == 0;
 }
 
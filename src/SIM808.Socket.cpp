@@ -0,0 +1,210 @@
+#include "SIM808.h"
+
+SIM808SocketReceiver::SIM808SocketReceiver(SIM808& sim808)
+{
+	_sim808 = &sim808;
+	_field = 0;
+	_link = 0;
+	_length = 0;
+	_remaining = 0;
+}
+
+size_t SIM808SocketReceiver::write(uint8_t c)
+{
+	if(_remaining) {
+		SIM808Socket* socket = _link < SIM808_MAX_SOCKETS ? _sim808->_sockets[_link] : NULL;
+		if(socket) socket->receive(c);
+
+		// the link is kept until its data has been received
+		if(!--_remaining) _link = 0;
+		return 1;
+	}
+
+	// reading the rest of the header, "<link>,<length>:"
+	if(c >= '0' && c <= '9') {
+		if(_field) _length = _length * 10 + c - '0';
+		else _link = _link * 10 + c - '0';
+	}
+	else if(c == ',') _field++;
+	else if(c == '\n') {
+		// the data directly follows the header, whatever it contains
+		_remaining = _length;
+		if(_length) _sim808->receiveData(*this, _length);
+		else _link = 0;
+
+		_field = 0;
+		_length = 0;
+	}
+
+	return 1;
+}
+
+SIM808Socket::SIM808Socket(SIM808& sim808, uint8_t* buffer, uint16_t size) : _ring(buffer, size)
+{
+	_sim808 = &sim808;
+	_dropped = 0;
+	_link = SIM808_SOCKET_NONE;
+	_connected = false;
+	_sending = false;
+	_writeFailed = false;
+	_sendResponse = 0;
+}
+
+SIM808Socket::~SIM808Socket()
+{
+	stop();
+}
+
+int SIM808Socket::open(SIM808SocketProtocol protocol, const char* host, uint16_t port)
+{
+	stop();
+
+	for(uint8_t i = 0; i < SIM808_MAX_SOCKETS; i++) {
+		if(_sim808->_sockets[i]) continue;
+
+		// claiming the link first, data might be received as soon as the connection is open
+		_link = i;
+		_sim808->_sockets[i] = this;
+		_connected = _sim808->socketOpen(i, protocol, host, port);
+		if(_connected) return 1;
+
+		_sim808->_sockets[i] = NULL;
+		_link = SIM808_SOCKET_NONE;
+		return 0;
+	}
+
+	return 0;
+}
+
+int SIM808Socket::connect(IPAddress ip, uint16_t port)
+{
+	char host[16];
+	snprintf_P(host, sizeof(host), PSTR("%u.%u.%u.%u"), ip[0], ip[1], ip[2], ip[3]);
+
+	return open(SIM808SocketProtocol::Tcp, host, port);
+}
+
+int SIM808Socket::connect(const char* host, uint16_t port)
+{
+	return open(SIM808SocketProtocol::Tcp, host, port);
+}
+
+int SIM808Socket::connectUdp(const char* host, uint16_t port)
+{
+	return open(SIM808SocketProtocol::Udp, host, port);
+}
+
+void SIM808Socket::receive(uint8_t c)
+{
+	if(!_ring.write(&c, 1)) _dropped++;
+}
+
+size_t SIM808Socket::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t SIM808Socket::write(const uint8_t* buf, size_t size)
+{
+	size_t written = 0;
+
+	if(!_connected) return 0;
+
+	flush();
+	_writeFailed = false;
+
+	while(written < size) {
+		size_t chunkSize = min(size - written, (size_t)SIM808_SOCKET_MAX_SEND);
+		bool last = written + chunkSize == size;
+
+		// only the acceptance of the last chunk is left to poll()
+		if(!_sim808->socketSend(_link, buf + written, chunkSize, last ? &_sendResponse : NULL)) {
+			_writeFailed = true;
+			break;
+		}
+
+		_sending = last;
+		written += chunkSize;
+	}
+
+	return written;
+}
+
+void SIM808Socket::updateSend()
+{
+	if(!_sending) return;
+
+	// another command has been sent meanwhile, the acceptance can no longer be read
+	if(_sim808->responseId() != _sendResponse) {
+		_sending = false;
+		return;
+	}
+
+	if(_sim808->responseStatus() == SIMComATResponseStatus::Pending) return;
+
+	_sending = false;
+	_writeFailed = _sim808->responseResult() != 0;
+}
+
+int SIM808Socket::available()
+{
+	// pumping the device, so that data is received without the sketch polling it
+	_sim808->poll();
+	updateSend();
+
+	return _ring.used();
+}
+
+int SIM808Socket::read()
+{
+	available();
+	return _ring.read();
+}
+
+int SIM808Socket::read(uint8_t* buf, size_t size)
+{
+	available();
+
+	uint16_t read = _ring.copy(buf, min(size, (size_t)_ring.capacity()));
+	_ring.release(read);
+
+	return read;
+}
+
+int SIM808Socket::peek()
+{
+	available();
+	return _ring.peek();
+}
+
+void SIM808Socket::flush()
+{
+	updateSend();
+
+	while(_sending) {
+		_sim808->poll();
+		updateSend();
+		yield();
+	}
+}
+
+void SIM808Socket::stop()
+{
+	if(_link == SIM808_SOCKET_NONE) return;
+
+	if(_connected) {
+		flush();
+		_sim808->socketClose(_link);
+	}
+	_sim808->_sockets[_link] = NULL;
+
+	_link = SIM808_SOCKET_NONE;
+	_connected = false;
+	_sending = false;
+	_ring.clear();
+}
+
+uint8_t SIM808Socket::connected()
+{
+	return available() || _connected;
+}
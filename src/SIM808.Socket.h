@@ -0,0 +1,141 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include "SIMComAT.Common.h"
+#include "SIMComAT.Ring.h"
+#include "SIM808.Types.h"
+
+#define SIM808_SOCKET_NONE 255	///< Link of a socket without connection.
+
+class SIM808;
+
+/**
+ * Demultiplexes the data pushed by the device for every open connection (+RECEIVE,<n>,<length>:)
+ * into the receive buffer of the matching SIM808Socket.
+ * Registered as the output of the +RECEIVE unsolicited result code, see SIM808::openSockets.
+ */
+class SIM808SocketReceiver : public Print
+{
+private:
+	SIM808* _sim808;
+	uint8_t _field;			///< Header field being read, link number then data length.
+	uint8_t _link;
+	uint16_t _length;
+	uint16_t _remaining;	///< Data bytes still to be received for the current link.
+
+public:
+	SIM808SocketReceiver(SIM808& sim808);
+
+	size_t write(uint8_t c);
+	using Print::write;
+};
+
+/**
+ * Client over one of the SIM808_MAX_SOCKETS connections the device can keep open at once (AT+CIPMUX=1).
+ * Data received from the remote end is buffered while poll, or any command, is reading from the device.
+ *
+ * Received bytes are stored in a caller provided buffer, whose size must be a power of two
+ * of at most 32768 bytes. See SIM808StaticSocket.
+ */
+class SIM808Socket : public Client
+{
+	friend class SIM808;
+	friend class SIM808SocketReceiver;
+
+private:
+	SIM808* _sim808;
+	SIMComATRing _ring;
+	uint16_t _dropped;
+	uint8_t _link;
+	bool _connected;
+	bool _sending;			///< The last chunk written is waiting to be accepted by the device.
+	bool _writeFailed;
+	uint8_t _sendResponse;	///< responseId() of the acceptance of the last chunk written.
+
+	/**
+	 * Open a connection on the first link available.
+	 */
+	int open(SIM808SocketProtocol protocol, const char* host, uint16_t port);
+	/**
+	 * Store a byte received from the remote end, dropping it if the buffer is full.
+	 */
+	void receive(uint8_t c);
+	/**
+	 * Update the state of the last chunk written from the response being read.
+	 */
+	void updateSend();
+
+public:
+	SIM808Socket(SIM808& sim808, uint8_t* buffer, uint16_t size);
+	~SIM808Socket();
+
+	int connect(IPAddress ip, uint16_t port);
+	int connect(const char* host, uint16_t port);
+	/**
+	 * Open a UDP connection to host. Datagrams are then sent and received with the Client interface.
+	 */
+	int connectUdp(const char* host, uint16_t port);
+
+	/**
+	 * Send a single byte. Prefer write(buf, size) which sends the whole buffer in a single command.
+	 */
+	size_t write(uint8_t c);
+	/**
+	 * Hand size bytes over to the device, SIM808_SOCKET_MAX_SEND bytes at a time.
+	 * Returns as soon as the last chunk is written, without waiting for the device to accept it :
+	 * its acceptance (AT+CIPQSEND=1) is read by poll(), see sending() and writeFailed().
+	 * Any other command sent meanwhile ends that wait, leaving the outcome unknown.
+	 */
+	size_t write(const uint8_t* buf, size_t size);
+	using Print::write;
+
+	/**
+	 * Get the number of bytes received and not read yet. Never blocks.
+	 */
+	int available();
+	int read();
+	int read(uint8_t* buf, size_t size);
+	int peek();
+	/**
+	 * Wait for the device to accept the last chunk written.
+	 */
+	void flush();
+	/**
+	 * Close the connection and release its link. Unread bytes are discarded.
+	 */
+	void stop();
+	/**
+	 * Get a boolean indicating wether or not the connection is open, or bytes are still waiting to be read.
+	 */
+	uint8_t connected();
+	operator bool() { return _link != SIM808_SOCKET_NONE; }
+
+	/**
+	 * Get the number of bytes received while the buffer was full, and thus lost.
+	 */
+	uint16_t dropped() { return _dropped; }
+	/**
+	 * Get a boolean indicating wether or not the last chunk written is still waiting to be accepted by the device.
+	 */
+	bool sending() { updateSend(); return _sending; }
+	/**
+	 * Get a boolean indicating wether or not the device refused the last chunk written.
+	 */
+	bool writeFailed() { updateSend(); return _writeFailed; }
+};
+
+/**
+ * SIM808Socket buffering received bytes in Size bytes of its own.
+ */
+template<uint16_t Size>
+class SIM808StaticSocket : public SIM808Socket
+{
+	static_assert(Size && !(Size & (Size - 1)) && Size <= 32768, "Size must be a power of two of at most 32768");
+
+private:
+	uint8_t _storage[Size];
+
+public:
+	SIM808StaticSocket(SIM808& sim808) : SIM808Socket(sim808, _storage, Size) { }
+};
@@ -0,0 +1,131 @@
+#include "SIM808.h"
+#include "SIM808.Gprs.h"
+
+AT_COMMAND(START_TASK, "+CSTT=\"%s\",\"%s\",\"%s\"");
+
+TOKEN_TEXT(CIPMUX, "+CIPMUX");
+TOKEN_TEXT(CIPQSEND, "+CIPQSEND");
+TOKEN_TEXT(RECEIVE, "+RECEIVE,");
+TOKEN_TEXT(PDP_DEACT, "+PDP: DEACT");
+TOKEN_TEXT(DATA_ACCEPT, "DATA ACCEPT");
+TOKEN_TEXT(PROMPT, ">");
+TOKEN_TEXT(CONNECT_OK, "CONNECT OK");
+TOKEN_TEXT(ALREADY_CONNECT, "ALREADY CONNECT");
+TOKEN_TEXT(CLOSE_OK, "CLOSE OK");
+TOKEN_TEXT(CLOSED, "CLOSED");
+TOKEN(TCP);
+TOKEN(UDP);
+
+AT_COMMAND_SPEC(BRING_UP_CONNECTION, "+CIICR", NULL, 65000);
+AT_COMMAND_SPEC(LOCAL_ADDRESS, "+CIFSR", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(SOCKET_START, "+CIPSTART=", NULL, 65000);
+AT_COMMAND_SPEC(SOCKET_SEND, "+CIPSEND=", TOKEN_DATA_ACCEPT, 5000);
+AT_COMMAND_SPEC(SOCKET_CLOSE, "+CIPCLOSE=", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+
+bool SIM808::openSockets(const char* apn, const char* user, const char* password)
+{
+	closeSockets();
+
+	beginBatch();
+	batchAT(TO_F(TOKEN_CIPMUX), TO_F(TOKEN_WRITE), 1);											//AT+CIPMUX=1
+	batchAT(TO_F(TOKEN_CIPQSEND), TO_F(TOKEN_WRITE), 1);										//AT+CIPQSEND=1
+	batchFormatAT(TO_F(AT_COMMAND_START_TASK), apn, user ? user : "", password ? password : "");	//AT+CSTT="xxx","xxx","xxx"
+	if(!endBatch()) return false;
+
+	sendCommandAT(AT_BRING_UP_CONNECTION);														//AT+CIICR
+	if(waitResponse(AT_BRING_UP_CONNECTION) != 0) return false;
+
+	// the local IP address is the only response
+	sendCommandAT(AT_LOCAL_ADDRESS);															//AT+CIFSR
+	if(waitResponse(AT_LOCAL_ADDRESS.timeout, NULL) != 0) return false;
+
+	unregisterUrcHandler(TO_F(TOKEN_RECEIVE));
+	return registerUrcHandler(TO_F(TOKEN_RECEIVE), _socketReceiver);
+}
+
+bool SIM808::closeSockets()
+{
+	for(uint8_t i = 0; i < SIM808_MAX_SOCKETS; i++) {
+		if(!_sockets[i]) continue;
+
+		// the connections are shut all at once below
+		_sockets[i]->_connected = false;
+		_sockets[i]->stop();
+	}
+
+	unregisterUrcHandler(TO_F(TOKEN_RECEIVE));
+
+	sendCommandAT(AT_SHUTDOWN_CONNECTIONS);														//AT+CIPSHUT
+	return waitResponse(AT_SHUTDOWN_CONNECTIONS) == 0;
+}
+
+bool SIM808::socketOpen(uint8_t link, SIM808SocketProtocol protocol, const char* host, uint16_t port)
+{
+	ATConstStr protocolToken = protocol == SIM808SocketProtocol::Udp ? TO_F(TOKEN_UDP) : TO_F(TOKEN_TCP);
+
+	sendCommandAT(AT_SOCKET_START, link, protocolToken, host, port);							//AT+CIPSTART=n,"TCP","xxx",xxx
+	if(waitResponse() != 0) return false;
+
+	return waitLinkResponse(link, AT_SOCKET_START.timeout, TOKEN_CONNECT_OK, TOKEN_ALREADY_CONNECT) != -1;
+}
+
+bool SIM808::socketSend(uint8_t link, const uint8_t* data, size_t size, uint8_t* response)
+{
+	sendCommandAT(AT_SOCKET_SEND, link, size);													//AT+CIPSEND=n,xxx
+	if(waitResponse(TO_F(TOKEN_PROMPT), TO_F(TOKEN_ERROR)) != 0) return false;
+
+	SENDARROW;
+	write(data, size);
+
+	if(!response) return waitResponse(AT_SOCKET_SEND) == 0;
+
+	beginResponse(AT_SOCKET_SEND);
+	*response = responseId();
+	return true;
+}
+
+bool SIM808::socketClose(uint8_t link)
+{
+	sendCommandAT(AT_SOCKET_CLOSE, link, 1);													//AT+CIPCLOSE=n,1
+	return waitLinkResponse(link, AT_SOCKET_CLOSE.timeout, TOKEN_CLOSE_OK, TOKEN_CLOSED) != -1;
+}
+
+int8_t SIM808::waitLinkResponse(uint8_t link, uint16_t timeout, const char* s1, const char* s2)
+{
+	uint32_t start = millis();
+	uint16_t elapsed;
+
+	while((elapsed = millis() - start) < timeout) {
+		if(waitResponse(timeout - elapsed, NULL) != 0) break;
+		if(!strncmp_P(replyBuffer, TOKEN_ERROR, strlen_P(TOKEN_ERROR))) break;
+
+		// link responses read "<n>, <status>"
+		if(replyBuffer[0] != '0' + link || replyBuffer[1] != ',') continue;
+
+		if(!strncmp_P(replyBuffer + 3, s1, strlen_P(s1))) return 0;
+		if(!strncmp_P(replyBuffer + 3, s2, strlen_P(s2))) return 1;
+		break;
+	}
+
+	return -1;
+}
+
+void SIM808::unhandledLine(const char* line, size_t length)
+{
+	if(bootLine(line)) return;
+
+	if(!strcmp_P(line, TOKEN_PDP_DEACT)) {
+		// the network dropped the context, and every connection with it
+		for(uint8_t i = 0; i < SIM808_MAX_SOCKETS; i++) {
+			if(_sockets[i]) _sockets[i]->_connected = false;
+		}
+
+		return;
+	}
+
+	// "<n>, CLOSED" when the remote end closed the connection
+	uint8_t link = line[0] - '0';
+	if(length < 4 || link >= SIM808_MAX_SOCKETS || line[1] != ',' || !_sockets[link]) return;
+
+	if(!strcmp_P(line + 3, TOKEN_CLOSED)) _sockets[link]->_connected = false;
+}
@@ -2,12 +2,20 @@
 
 #include <Arduino.h>
 
+#define GPS_ACCURATE_FIX_MIN_SATELLITES 4
+
 enum class SIM808Echo : uint8_t
 {
 	Off = 0,
 	On = 1
 };
 
+/**
+ * Callback reconfiguring the host UART connected to the device at the given baudrate.
+ * See SIM808::negotiateBaudrate.
+ */
+typedef void (*SIM808BaudrateCallback)(uint32_t baudrate);
+
 enum class SIM808SmsMessageFormat : uint8_t
 {
 	Pdu = 0,
@@ -45,6 +53,16 @@ enum class SIM808RegistrationStatusResponse : uint8_t
 	Ci = 3		///< Location information.
 };
 
+/**
+ * Modes of the network registration unsolicited result code (+CGREG).
+ */
+enum class SIM808RegistrationUrc : uint8_t
+{
+	Disable = 0,			///< No unsolicited result code.
+	Enable = 1,				///< +CGREG: <stat> on every registration change.
+	EnableWithLocation = 2	///< +CGREG: <stat>[,<lac>,<ci>] on every registration or cell change.
+};
+
 /**
  * Fields return by the AT+CSQ command.
  */
@@ -83,6 +101,54 @@ enum class SIM808GpsField : uint8_t
 	GnssUsed = 15		///< GPS satellites used to acquire the position.
 };
 
+/**
+ * Typed content of a +CGNSINF sequence, with fixed point values.
+ * Reserved fields are not kept.
+ */
+struct SIM808GnssFix
+{
+	uint8_t runStatus;		///< GNSS run status, 1 when powered on.
+	uint8_t fixStatus;		///< Fix status, 1 when a fix is acquired.
+	uint16_t year;			///< UTC year.
+	uint8_t month;			///< UTC month, from 1 to 12.
+	uint8_t day;			///< UTC day of the month, from 1 to 31.
+	uint8_t hour;			///< UTC hour.
+	uint8_t minute;			///< UTC minute.
+	uint8_t second;			///< UTC second.
+	uint16_t millisecond;	///< UTC millisecond.
+	int32_t latitude;		///< Latitude, in microdegrees.
+	int32_t longitude;		///< Longitude, in microdegrees.
+	int32_t altitude;		///< MSL altitude, in centimetres.
+	uint32_t speed;			///< Speed over ground, in m/h.
+	uint16_t course;		///< Course over ground, in hundredths of degree.
+	uint8_t fixMode;		///< Fix mode.
+	uint16_t hdop;			///< Horizontal dilution of precision, in hundredths.
+	uint16_t pdop;			///< Position dilution of precision, in hundredths.
+	uint16_t vdop;			///< Vertical dilution of precision, in hundredths.
+	uint8_t gpsInView;		///< GPS satellites in view.
+	uint8_t gnssUsed;		///< GNSS satellites used to acquire the position.
+	uint8_t glonassInView;	///< GLONASS satellites in view.
+	uint8_t cn0Max;			///< Maximum carrier to noise ratio, in dBHz.
+	uint32_t hpa;			///< Horizontal position accuracy, in centimetres.
+	uint32_t vpa;			///< Vertical position accuracy, in centimetres.
+};
+
+/**
+ * Origin of the position held by a SIM808Locator.
+ */
+enum class SIM808LocationSource : uint8_t
+{
+	None = 0,			///< No position has been acquired yet.
+	Cell = 1,			///< Coarse position computed by the network. See SIM808::getCellLocation.
+	Gnss = 2,			///< GPS fix.
+	AccurateGnss = 3	///< GPS fix using more than the required satellites.
+};
+
+/**
+ * Callback receiving each fix streamed by the module. See SIM808::startGpsStream.
+ */
+typedef void (*SIM808GnssFixCallback)(const SIM808GnssFix& fix);
+
 enum class SIM808BatteryChargeField : uint8_t
 {
 	Bcs = 0,	///< Battery Charge State.
@@ -116,6 +182,51 @@ enum class SIM808NetworkRegistrationState : int8_t
 	Roaming = 5			///< Registered to a network that is not the home network.
 };
 
+#define SIM808_BOOT_PHASES 5
+
+/**
+ * Readiness signals sent by the device while booting, in their usual order.
+ */
+enum class SIM808BootPhase : uint8_t
+{
+	Rdy = 0,			///< The serial link is ready (RDY).
+	Functionality = 1,	///< The device is fully functional (+CFUN: 1).
+	Sim = 2,			///< The SIM card is ready (+CPIN: READY).
+	Call = 3,			///< Calls can be made (Call Ready).
+	Sms = 4				///< SMS can be sent (SMS Ready).
+};
+
+/**
+ * Time at which each boot phase has been reached, in ms since the device was reset
+ * or powered on, or 0 if it has not been reached yet.
+ */
+struct SIM808BootTimings
+{
+	uint16_t phases[SIM808_BOOT_PHASES];	///< Indexed by SIM808BootPhase.
+};
+
+/**
+ * Progress of a SIM808ConnectionManager towards an open GPRS bearer.
+ */
+enum class SIM808ConnectionState : uint8_t
+{
+	Idle = 0,			///< The manager has not been started, or has been stopped.
+	Registering = 1,	///< Waiting for the device to register to the network.
+	Attaching = 2,		///< Attaching to the GPRS service.
+	OpeningBearer = 3,	///< Configuring and opening the bearer.
+	Connected = 4,		///< The bearer is open, and checked periodically.
+	Checking = 5		///< The bearer was open at the last check, and is being checked again. The device is busy meanwhile.
+};
+
+/**
+ * Transport protocols of a SIM808Socket.
+ */
+enum class SIM808SocketProtocol : uint8_t
+{
+	Tcp = 0,
+	Udp = 1
+};
+
 struct SIM808SignalQualityReport
 {
 	uint8_t rssi;		///< Received Signal Strength Indication, from 0 (worst) to 31 (best). 99 means unknown. 
@@ -128,4 +239,18 @@ struct SIM808ChargingStatus
 	SIM808ChargingState state;	///< Current charging state.
 	int8_t level;					///< Battery level, expressed as a percentage.
 	int16_t voltage;				///< Battery level, expressed in mV.
+};
+/**
+ * Called repeatedly to get the next bytes of a HTTP request body, starting at offset.
+ * Writes at most size bytes into buffer and returns the number of bytes written.
+ * Returning 0 aborts the request.
+ */
+typedef size_t (*SIM808HttpBodyProducer)(uint8_t* buffer, size_t size, uint32_t offset);
+
+struct SIM808HttpTransferReport
+{
+	uint32_t size;			///< Response body size announced by the server, in bytes.
+	uint32_t transferred;	///< Bytes actually read from the device.
+	uint32_t duration;		///< Time spent reading the response, in ms.
+	uint32_t throughput;	///< Effective transfer rate, in bytes per second.
 };
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "SIM808.h"
+
+#if defined(SIM808_WORKER)
+
+SIM808Request::SIM808Request(SIM808WorkerJob job, void* context, SIM808WorkerCallback callback)
+{
+	_job = job;
+	_context = context;
+	_callback = callback;
+	_result = -1;
+}
+
+void SIM808Request::complete(int32_t result)
+{
+	_result = result;
+
+	if(_callback) _callback(result, _context);
+	_done.give();
+}
+
+bool SIM808Request::wait(uint32_t timeout)
+{
+	if(!_done.take(timeout)) return false;
+
+	// staying done for the next waits, until submitted again
+	_done.give();
+	return true;
+}
+
+SIM808Worker::SIM808Worker(SIM808& sim808)
+{
+	_sim808 = &sim808;
+	_stopping = false;
+	_idleJob = NULL;
+	_idleContext = NULL;
+}
+
+bool SIM808Worker::begin(uint32_t stackSize, uint8_t priority, int32_t core)
+{
+	_stopping = false;
+	return _thread.start(run, this, stackSize, priority, core);
+}
+
+void SIM808Worker::end()
+{
+	if(!_thread.started()) return;
+
+	_stopping = true;
+	_signal.give();
+	_thread.join();
+}
+
+void SIM808Worker::setIdleJob(SIM808WorkerJob job, void* context)
+{
+	_idleJob = job;
+	_idleContext = context;
+}
+
+bool SIM808Worker::submit(SIM808Request& request, SIM808WorkerPriority priority, uint32_t timeout)
+{
+	// forgetting the completion of a previous submission
+	request._done.take(0);
+
+	if(!_queues[(uint8_t)priority].send(&request, timeout)) return false;
+
+	_signal.give();
+	return true;
+}
+
+int32_t SIM808Worker::call(SIM808WorkerJob job, void* context, SIM808WorkerPriority priority)
+{
+	SIM808Request request(job, context);
+
+	if(!submit(request, priority)) return -1;
+
+	request.wait();
+	return request.result();
+}
+
+SIM808Request* SIM808Worker::next()
+{
+	SIM808Request* request;
+
+	for(uint8_t i = 0; i < SIM808_WORKER_PRIORITIES; i++) {
+		request = (SIM808Request*)_queues[i].receive();
+		if(request) return request;
+	}
+
+	return NULL;
+}
+
+void SIM808Worker::run(void* worker)
+{
+	SIM808Worker* self = (SIM808Worker*)worker;
+	SIM808Request* request;
+
+	while(!self->_stopping) {
+		if(self->_idleJob) self->_idleJob(*self->_sim808, self->_idleContext);
+		else self->_sim808->poll();
+
+		// a job would steal the response awaited by the idle job
+		request = self->_sim808->responseStatus() == SIMComATResponseStatus::Pending ?
+			NULL :
+			self->next();
+
+		if(!request) {
+			self->_signal.take(SIM808_WORKER_POLL_INTERVAL);
+			continue;
+		}
+
+		request->complete(request->_job(*self->_sim808, request->_context));
+	}
+}
+
+#endif // SIM808_WORKER
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIM808.WorkerPlatform.h"
+
+#if defined(SIM808_WORKER)
+
+#define SIM808_WORKER_STACK_SIZE 4096		///< Stack of the worker task, in bytes.
+#define SIM808_WORKER_TASK_PRIORITY 2
+#define SIM808_WORKER_POLL_INTERVAL 10		///< Delay between two polls of the device while no request is waiting, in ms.
+
+class SIM808;
+
+/**
+ * Operation run by the worker with exclusive access to the device.
+ * context is the one given with the request.
+ */
+typedef int32_t (*SIM808WorkerJob)(SIM808& sim808, void* context);
+/**
+ * Called from the worker task once a request has been run, with the result of its job.
+ */
+typedef void (*SIM808WorkerCallback)(int32_t result, void* context);
+
+/**
+ * Order in which waiting requests are run. Requests of the same priority are run in submission order.
+ */
+enum class SIM808WorkerPriority : uint8_t
+{
+	High = 0,
+	Normal = 1,
+	Low = 2
+};
+
+#define SIM808_WORKER_PRIORITIES 3
+
+/**
+ * A job submitted to a SIM808Worker, and the future of its result.
+ * Must not be destroyed before wait() returns true, and can be submitted again from then.
+ */
+class SIM808Request
+{
+private:
+	friend class SIM808Worker;
+
+	SIM808WorkerJob _job;
+	void* _context;
+	SIM808WorkerCallback _callback;
+	SIM808WorkerSignal _done;	///< Given once the job has run and the callback has returned.
+	volatile int32_t _result;
+
+	/**
+	 * Publish the result. The request may be destroyed by its owner as soon as _done is given,
+	 * so nothing is touched afterwards.
+	 */
+	void complete(int32_t result);
+
+public:
+	SIM808Request(SIM808WorkerJob job, void* context = NULL, SIM808WorkerCallback callback = NULL);
+
+	/**
+	 * Block the calling thread until the job has been run and its callback has returned, at most timeout ms.
+	 * Returns false if it has not been run in time.
+	 */
+	bool wait(uint32_t timeout = SIM808_WORKER_FOREVER);
+	/**
+	 * Get a boolean indicating wether or not the job has been run and its callback has returned, without waiting.
+	 */
+	bool completed() { return _done.given(); }
+	/**
+	 * Get the value returned by the job. Only valid once completed.
+	 */
+	int32_t result() { return _result; }
+};
+
+/**
+ * Owns a SIM808 instance from a dedicated FreeRTOS task, or thread on a host, so that several tasks can use the device
+ * without locking it themselves. Requests are taken from a queue per priority, highest first,
+ * and each job runs alone on the device.
+ *
+ * A job blocks the worker for as long as its commands take. Long operations are best split in
+ * short steps run from the idle job, such as SIM808ConnectionManager::tick, so that waiting
+ * requests are run between two steps. Requests are never run while an asynchronous command
+ * sent by the idle job is still awaited.
+ *
+ * Once begin() is called, the SIM808 instance must only be used from jobs.
+ */
+class SIM808Worker
+{
+private:
+	SIM808* _sim808;
+	SIM808WorkerQueue _queues[SIM808_WORKER_PRIORITIES];
+	SIM808WorkerSignal _signal;	///< Given on each submission to wake the worker up.
+	SIM808WorkerThread _thread;
+	volatile bool _stopping;
+	SIM808WorkerJob _idleJob;
+	void* _idleContext;
+
+	static void run(void* worker);
+	/**
+	 * Take the oldest request of the highest priority waiting, or NULL.
+	 */
+	SIM808Request* next();
+
+public:
+	SIM808Worker(SIM808& sim808);
+
+	/**
+	 * Start the worker task. Returns false if it could not be created.
+	 */
+	bool begin(uint32_t stackSize = SIM808_WORKER_STACK_SIZE, uint8_t priority = SIM808_WORKER_TASK_PRIORITY, int32_t core = SIM808_WORKER_ANY_CORE);
+	/**
+	 * Stop the worker task once the job being run, if any, has returned. Requests still waiting are not run.
+	 * Must not be called from a job.
+	 */
+	void end();
+	/**
+	 * Set the job run whenever no request is waiting, in place of SIM808::poll. Its result is ignored.
+	 * Must be called before begin().
+	 */
+	void setIdleJob(SIM808WorkerJob job, void* context = NULL);
+
+	/**
+	 * Queue request to be run by the worker, waiting at most timeout ms for room in the queue.
+	 * Returns false if the queue stayed full.
+	 */
+	bool submit(SIM808Request& request, SIM808WorkerPriority priority = SIM808WorkerPriority::Normal, uint32_t timeout = SIM808_WORKER_FOREVER);
+	/**
+	 * Run job on the worker and wait for its result. Must not be called from a job.
+	 * Returns -1 if the job could not be queued.
+	 */
+	int32_t call(SIM808WorkerJob job, void* context = NULL, SIM808WorkerPriority priority = SIM808WorkerPriority::Normal);
+};
+
+#endif // SIM808_WORKER
@@ -0,0 +1,200 @@
+#include "SIM808.WorkerPlatform.h"
+
+#if defined(SIM808_WORKER_STD_THREAD)
+
+#include <chrono>
+
+template<typename Predicate> static bool waitFor(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, uint32_t timeout, Predicate predicate)
+{
+	if(timeout == SIM808_WORKER_FOREVER) {
+		condition.wait(lock, predicate);
+		return true;
+	}
+
+	return condition.wait_for(lock, std::chrono::milliseconds(timeout), predicate);
+}
+
+SIM808WorkerSignal::SIM808WorkerSignal()
+{
+	_given = false;
+}
+
+SIM808WorkerSignal::~SIM808WorkerSignal() { }
+
+void SIM808WorkerSignal::give()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_given = true;
+	_changed.notify_one();
+}
+
+bool SIM808WorkerSignal::take(uint32_t timeout)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	if(!waitFor(_changed, lock, timeout, [this] { return _given; })) return false;
+
+	_given = false;
+	return true;
+}
+
+bool SIM808WorkerSignal::given()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _given;
+}
+
+SIM808WorkerQueue::SIM808WorkerQueue()
+{
+	_head = 0;
+	_length = 0;
+}
+
+SIM808WorkerQueue::~SIM808WorkerQueue() { }
+
+bool SIM808WorkerQueue::send(void* item, uint32_t timeout)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	if(!waitFor(_dequeued, lock, timeout, [this] { return _length < SIM808_WORKER_QUEUE_LENGTH; })) return false;
+
+	_items[(_head + _length) % SIM808_WORKER_QUEUE_LENGTH] = item;
+	_length++;
+	return true;
+}
+
+void* SIM808WorkerQueue::receive()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	void* item;
+
+	if(!_length) return NULL;
+
+	item = _items[_head];
+	_head = (_head + 1) % SIM808_WORKER_QUEUE_LENGTH;
+	_length--;
+
+	_dequeued.notify_one();
+	return item;
+}
+
+SIM808WorkerThread::SIM808WorkerThread()
+{
+	_function = NULL;
+	_argument = NULL;
+}
+
+bool SIM808WorkerThread::start(void (*function)(void* argument), void* argument, uint32_t stackSize, uint8_t priority, int32_t core)
+{
+	_function = function;
+	_argument = argument;
+	_thread = std::thread(function, argument);
+
+	return true;
+}
+
+void SIM808WorkerThread::join()
+{
+	_thread.join();
+}
+
+bool SIM808WorkerThread::started()
+{
+	return _thread.joinable();
+}
+
+#elif defined(ESP32)
+
+static TickType_t toTicks(uint32_t timeout)
+{
+	return timeout == SIM808_WORKER_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout);
+}
+
+SIM808WorkerSignal::SIM808WorkerSignal()
+{
+	_semaphore = xSemaphoreCreateBinaryStatic(&_buffer);
+}
+
+SIM808WorkerSignal::~SIM808WorkerSignal()
+{
+	vSemaphoreDelete(_semaphore);
+}
+
+void SIM808WorkerSignal::give()
+{
+	xSemaphoreGive(_semaphore);
+}
+
+bool SIM808WorkerSignal::take(uint32_t timeout)
+{
+	return xSemaphoreTake(_semaphore, toTicks(timeout)) == pdTRUE;
+}
+
+bool SIM808WorkerSignal::given()
+{
+	return uxSemaphoreGetCount(_semaphore) != 0;
+}
+
+SIM808WorkerQueue::SIM808WorkerQueue()
+{
+	_queue = xQueueCreateStatic(SIM808_WORKER_QUEUE_LENGTH, sizeof(void*), _storage, &_buffer);
+}
+
+SIM808WorkerQueue::~SIM808WorkerQueue()
+{
+	vQueueDelete(_queue);
+}
+
+bool SIM808WorkerQueue::send(void* item, uint32_t timeout)
+{
+	return xQueueSend(_queue, &item, toTicks(timeout)) == pdTRUE;
+}
+
+void* SIM808WorkerQueue::receive()
+{
+	void* item;
+
+	return xQueueReceive(_queue, &item, 0) == pdTRUE ? item : NULL;
+}
+
+SIM808WorkerThread::SIM808WorkerThread()
+{
+	_task = NULL;
+	_function = NULL;
+	_argument = NULL;
+}
+
+void SIM808WorkerThread::run(void* thread)
+{
+	SIM808WorkerThread* self = (SIM808WorkerThread*)thread;
+
+	self->_function(self->_argument);
+	self->_stopped.give();
+
+	vTaskDelete(NULL);
+}
+
+bool SIM808WorkerThread::start(void (*function)(void* argument), void* argument, uint32_t stackSize, uint8_t priority, int32_t core)
+{
+	_function = function;
+	_argument = argument;
+
+	if(xTaskCreatePinnedToCore(run, "SIM808", stackSize, this, priority, &_task, core) == pdPASS) return true;
+
+	_task = NULL;
+	return false;
+}
+
+void SIM808WorkerThread::join()
+{
+	_stopped.take();
+	_task = NULL;
+}
+
+bool SIM808WorkerThread::started()
+{
+	return _task != NULL;
+}
+
+#endif // SIM808_WORKER_STD_THREAD
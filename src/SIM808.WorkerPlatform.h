@@ -0,0 +1,140 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Threading primitives used by SIM808Worker, on top of FreeRTOS on ESP32,
+ * or of the standard library when SIM808_WORKER_STD_THREAD is defined, to run the worker on a host.
+ * Timeouts are in ms, SIM808_WORKER_FOREVER waiting with no limit.
+ */
+
+#if defined(SIM808_WORKER_STD_THREAD)
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define SIM808_WORKER_ANY_CORE -1
+
+#elif defined(ESP32)
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define SIM808_WORKER_ANY_CORE tskNO_AFFINITY
+
+#endif
+
+#if defined(SIM808_WORKER_STD_THREAD) || defined(ESP32)
+
+#define SIM808_WORKER
+
+#define SIM808_WORKER_FOREVER UINT32_MAX
+#define SIM808_WORKER_QUEUE_LENGTH 8		///< Requests waiting at each priority.
+
+/**
+ * Binary semaphore : given once, taken once.
+ */
+class SIM808WorkerSignal
+{
+private:
+#if defined(SIM808_WORKER_STD_THREAD)
+	std::mutex _mutex;
+	std::condition_variable _changed;
+	bool _given;
+#else
+	StaticSemaphore_t _buffer;
+	SemaphoreHandle_t _semaphore;
+#endif
+
+public:
+	SIM808WorkerSignal();
+	~SIM808WorkerSignal();
+
+	/**
+	 * Give the signal, waking up a thread waiting for it. Giving a given signal does nothing.
+	 * The signal may be destroyed by the woken thread as soon as it is given, and is not touched afterwards.
+	 */
+	void give();
+	/**
+	 * Take the signal, waiting at most timeout ms for it to be given.
+	 * Returns false if it has not been given in time.
+	 */
+	bool take(uint32_t timeout = SIM808_WORKER_FOREVER);
+	/**
+	 * Get a boolean indicating wether or not the signal is given, without taking it.
+	 */
+	bool given();
+};
+
+/**
+ * Fixed length FIFO of pointers, safe to use from several threads.
+ */
+class SIM808WorkerQueue
+{
+private:
+#if defined(SIM808_WORKER_STD_THREAD)
+	std::mutex _mutex;
+	std::condition_variable _dequeued;
+	void* _items[SIM808_WORKER_QUEUE_LENGTH];
+	uint8_t _head;
+	uint8_t _length;
+#else
+	StaticQueue_t _buffer;
+	uint8_t _storage[SIM808_WORKER_QUEUE_LENGTH * sizeof(void*)];
+	QueueHandle_t _queue;
+#endif
+
+public:
+	SIM808WorkerQueue();
+	~SIM808WorkerQueue();
+
+	/**
+	 * Append item, waiting at most timeout ms for room in the queue.
+	 * Returns false if the queue stayed full.
+	 */
+	bool send(void* item, uint32_t timeout = SIM808_WORKER_FOREVER);
+	/**
+	 * Remove the oldest item, or return NULL if the queue is empty.
+	 */
+	void* receive();
+};
+
+/**
+ * Thread running a single function until it returns.
+ */
+class SIM808WorkerThread
+{
+private:
+#if defined(SIM808_WORKER_STD_THREAD)
+	std::thread _thread;
+#else
+	TaskHandle_t _task;
+	SIM808WorkerSignal _stopped;
+
+	static void run(void* thread);
+#endif
+	void (*_function)(void* argument);
+	void* _argument;
+
+public:
+	SIM808WorkerThread();
+
+	/**
+	 * Start running function(argument). stackSize, priority and core are ignored when running on a host.
+	 * Returns false if the thread could not be created.
+	 */
+	bool start(void (*function)(void* argument), void* argument, uint32_t stackSize, uint8_t priority, int32_t core);
+	/**
+	 * Wait for the function to return. Must not be called from the thread itself.
+	 */
+	void join();
+	/**
+	 * Get a boolean indicating wether or not the thread has been started and not joined yet.
+	 */
+	bool started();
+};
+
+#endif // SIM808_WORKER_STD_THREAD || ESP32
@@ -1,12 +1,29 @@
 #include "SIM808.h"
 
-TOKEN(RDY);
-
-SIM808::SIM808(uint8_t resetPin, uint8_t pwrKeyPin, uint8_t statusPin)
+AT_COMMAND_SPEC(ECHO, "E", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(BAUDRATE, "+IPR=", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+AT_COMMAND_SPEC(ERROR_REPORTING, "+CMEE=", NULL, SIMCOMAT_DEFAULT_TIMEOUT);
+
+#define BAUDRATES_COUNT 10
+
+/**
+ * Fixed baudrates supported by the device, from the highest.
+ */
+const uint32_t BAUDRATES[BAUDRATES_COUNT] S_PROGMEM = {
+	460800, 230400, 115200, 57600, 38400, 19200, 9600, 4800, 2400, 1200
+};
+
+SIM808::SIM808(char* replyBuffer, size_t replyBufferSize, uint8_t resetPin, uint8_t pwrKeyPin, uint8_t statusPin) :
+	SIMComAT(replyBuffer, replyBufferSize),
+	_socketReceiver(*this)
 {
 	_resetPin = resetPin;
 	_pwrKeyPin = pwrKeyPin;
 	_statusPin = statusPin;
+	_userAgent = NULL;
+	_httpService = 0;
+	for(uint8_t i = 0; i < SIM808_MAX_SOCKETS; i++) _sockets[i] = NULL;
+	beginBoot(0);
 
 	pinMode(_resetPin, OUTPUT);
 	if(_pwrKeyPin != SIM808_UNAVAILABLE_PIN) pinMode(_pwrKeyPin, OUTPUT);
@@ -22,13 +39,26 @@ SIM808::~SIM808() { }
 
 void SIM808::init()
 {
+	init(SIM808BootPhase::Functionality, SIM808_BOOT_SETTLE_TIMEOUT);
+}
+
+bool SIM808::init(SIM808BootPhase phase, uint16_t timeout)
+{
+	bool ready;
+
 	SIM808_PRINT_SIMPLE_P("Init...");
 
 	reset();
 	waitForReady();
-	delay(1500);
+	ready = waitForBoot(phase, timeout);
 
 	setEcho(SIM808Echo::Off);
+
+	// numeric +CME ERROR: <n> instead of a bare ERROR, see errorCode()
+	sendCommandAT(AT_ERROR_REPORTING, 1);
+	waitResponse(AT_ERROR_REPORTING);
+
+	return ready;
 }
 
 void SIM808::reset()
@@ -39,6 +69,7 @@ void SIM808::reset()
 	delay(200);
 
 	digitalWrite(_resetPin, HIGH);
+	beginBoot(millis());
 }
 
 void SIM808::waitForReady()
@@ -50,24 +81,89 @@ void SIM808::waitForReady()
 	// Despite official documentation, we can get an "AT" back without a "RDY" first.
 	} while (waitResponse(TO_F(TOKEN_AT)) != 0);
 
-	// we got AT, waiting for RDY
-	while (waitResponse(TO_F(TOKEN_RDY)) != 0);
+	// we got AT, waiting for RDY unless it came first
+	while (!waitForBoot(SIM808BootPhase::Rdy, SIMCOMAT_DEFAULT_TIMEOUT));
 }
 
 bool SIM808::setEcho(SIM808Echo mode)
 {
-	sendAT(S_F("E"), (uint8_t)mode);
+	sendCommandAT(AT_ECHO, (uint8_t)mode);
+
+	return waitResponse(AT_ECHO) == 0;
+}
+
+bool SIM808::verifyLink()
+{
+	uint8_t passed = 0;
+
+	// in autobauding mode, the first command might only be used by the device to detect the baudrate
+	for(uint8_t i = 0; i < SIM808_BAUDRATE_PINGS + 2 && passed < SIM808_BAUDRATE_PINGS; i++) {
+		sendAT();
+		passed = waitResponse(SIM808_BAUDRATE_PING_TIMEOUT) == 0 ? passed + 1 : 0;
+	}
+
+	return passed == SIM808_BAUDRATE_PINGS;
+}
+
+bool SIM808::revertBaudrate(SIM808BaudrateCallback setBaudrate, uint32_t corrupted, uint32_t reliable)
+{
+	for(uint8_t i = 0; i < SIM808_BAUDRATE_REVERT_ATTEMPTS; i++) {
+		// the command itself may be corrupted on its way to the device
+		setBaudrate(corrupted);
+		sendCommandAT(AT_BAUDRATE, reliable);
+		waitResponse(SIM808_BAUDRATE_PING_TIMEOUT);
+
+		setBaudrate(reliable);
+		if(verifyLink()) return true;
+	}
+
+	return false;
+}
+
+uint32_t SIM808::detectBaudrate(SIM808BaudrateCallback setBaudrate)
+{
+	for(uint8_t i = 0; i < BAUDRATES_COUNT; i++) {
+		uint32_t baudrate = pgm_read_dword(&BAUDRATES[i]);
+
+		setBaudrate(baudrate);
+		if(verifyLink()) return baudrate;
+	}
+
+	return 0;
+}
+
+uint32_t SIM808::negotiateBaudrate(SIM808BaudrateCallback setBaudrate, uint32_t maxBaudrate)
+{
+	uint32_t current = detectBaudrate(setBaudrate);
+	if(!current) return 0;
+
+	for(uint8_t i = 0; i < BAUDRATES_COUNT; i++) {
+		uint32_t baudrate = pgm_read_dword(&BAUDRATES[i]);
+		if(baudrate > maxBaudrate) continue;
+		if(baudrate <= current) break;
+
+		SIM808_PRINT_P("negotiateBaudrate: %l", baudrate);
+
+		// the device acknowledges at the current baudrate before switching
+		sendCommandAT(AT_BAUDRATE, baudrate);
+		if(waitResponse(AT_BAUDRATE) != 0) continue;
+
+		setBaudrate(baudrate);
+		if(verifyLink()) return baudrate;
+
+		if(!revertBaudrate(setBaudrate, baudrate, current) && !(current = detectBaudrate(setBaudrate))) return 0;
+	}
 
-	return waitResponse() == 0;
+	return current;
 }
 
 size_t SIM808::sendCommand(const char *cmd, char *response, size_t responseSize)
 {
 	flushInput();
-	sendAT(cmd);
+	sendRawAT(cmd);
 	
 	uint16_t timeout = SIMCOMAT_DEFAULT_TIMEOUT;
-	readNext(response, responseSize, &timeout);
+	return readNext(response, responseSize, &timeout);
 }
 
 #pragma endregion
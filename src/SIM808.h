@@ -2,45 +2,137 @@
 
 #include <SIMComAT.h>
 #include "SIM808.Types.h"
+#include "SIM808.HttpSession.h"
+#include "SIM808.GnssParser.h"
+#include "SIM808.FixBuffer.h"
+#include "SIM808.Socket.h"
+#include "SIM808.ConnectionManager.h"
+#include "SIM808.Locator.h"
+#include "SIM808.Worker.h"
 
 #define HTTP_TIMEOUT 10000L
-#define GPS_ACCURATE_FIX_MIN_SATELLITES 4
+#define HTTP_READ_CHUNK_SIZE 512	///< Size of each window read from a HTTP response when streaming it.
+#define HTTP_WRITE_CHUNK_SIZE 32	///< Size of the stack buffer used to stream a HTTP request body.
+#define HTTP_BODY_TIMEOUT 120000L	///< Maximum time given to the device to receive a streamed HTTP request body.
 #define SIM808_UNAVAILABLE_PIN 255
+#define SIM808_MAX_BAUDRATE 115200				///< Highest baudrate tried by negotiateBaudrate by default.
+#define SIM808_BAUDRATE_PINGS 3					///< Consecutive commands that must succeed for a baudrate to be kept.
+#define SIM808_BAUDRATE_PING_TIMEOUT 200
+#define SIM808_BAUDRATE_REVERT_ATTEMPTS 5		///< Times the previous baudrate is asked for over a corrupted link.
+#define SIM808_MAX_SOCKETS 6					///< Connections the device can keep open at once.
+#define SIM808_SOCKET_MAX_SEND 1024				///< Maximum number of bytes sent by a single AT+CIPSEND.
+#define SIM808_BOOT_SETTLE_TIMEOUT 1500			///< Longest wait for the device to be fully functional in init().
+#define SIM808_PWRKEY_MIN_PULSE 1000			///< Shortest PWRKEY pulse turning the device on or off.
+#define SIM808_PWRKEY_PULSE 2000				///< PWRKEY pulse when the status pin does not tell the device state.
+#define SIM808_POWER_TIMEOUT 2000				///< Longest wait for the device to reach its new power state.
+#define SIM808_STATUS_POLL_INTERVAL 10
+#define SIM808_AT_POLL_INTERVAL 150
 
 class SIM808 : public SIMComAT
 {
+	friend class SIM808HttpSession;
+	friend class SIM808Socket;
+	friend class SIM808SocketReceiver;
+	friend class SIM808ConnectionManager;
+
 private:
 	uint8_t _resetPin;
 	uint8_t _statusPin;
 	uint8_t _pwrKeyPin;
 	const char* _userAgent;
+	uint8_t _httpService;	///< Changes each time the HTTP service is terminated.
+	SIM808Socket* _sockets[SIM808_MAX_SOCKETS];	///< Socket using each link, if any.
+	SIM808SocketReceiver _socketReceiver;
+	uint32_t _bootStart;
+	uint8_t _bootPhases;	///< Boot phases reached, one bit each.
+	SIM808BootTimings _bootTimings;
 
 	/**
 	 * Wait for the device to be ready to accept communcation.
 	 */
 	void waitForReady();	
+	/**
+	 * Forget the boot phases reached, the device booting again from start.
+	 */
+	void beginBoot(uint32_t start);
+	/**
+	 * Record the boot phase announced by line, if any. Returns false if line is not a boot signal.
+	 */
+	bool bootLine(const char* line);
+	/**
+	 * Get a boolean indicating wether or not SIM808_BAUDRATE_PINGS consecutive commands succeed at the current baudrate.
+	 */
+	bool verifyLink();
+	/**
+	 * Ask the device blindly to switch back from a corrupted baudrate to a reliable one,
+	 * until the link is verified at the reliable baudrate. Returns false if it never is.
+	 */
+	bool revertBaudrate(SIM808BaudrateCallback setBaudrate, uint32_t corrupted, uint32_t reliable);
+
+	/**
+	 * HTTP settings sent by sendHttpParameters, one bit each.
+	 */
+	enum HttpParameters : uint8_t
+	{
+		HttpService = 1,		///< HTTPINIT, then the redirections and bearer profile.
+		HttpUrl = 2,
+		HttpSsl = 4,			///< HTTPSSL, enabled for https URLs.
+		HttpUserAgent = 8,		///< Only sent if a user agent is set.
+		HttpContentType = 16,	///< Only sent if contentType is not NULL.
+		HttpAll = 31
+	};
 
 	/**
 	 * Set all the parameters up for a HTTP request to be fired next.
+	 * The content type is only set if not NULL.
+	 */
+	bool setupHttpRequest(const char* url, ATConstStr contentType = NULL);
+	/**
+	 * Send the HTTP settings selected by parameters, a combination of HttpParameters, as a single batch.
+	 * The service must have been terminated before if HttpService is selected.
 	 */
-	bool setupHttpRequest(const char* url);
+	bool sendHttpParameters(const char* url, ATConstStr contentType, uint8_t parameters);
 	/**
 	 * Fire a HTTP request and return the server response code and body size.
 	 */
-	bool fireHttpRequest(const SIM808HttpAction action, uint16_t *statusCode, size_t *dataSize);
+	bool fireHttpRequest(const SIM808HttpAction action, uint16_t *statusCode, ATDataSize *dataSize);
 	/**
 	 * Read the last HTTP response body into response.
 	 */
-	bool readHttpResponse(char *response, size_t responseSize, size_t dataSize);	
-	bool setHttpParameter(ATConstStr parameter, ATConstStr value);
+	bool readHttpResponse(char *response, size_t responseSize, ATDataSize dataSize);
+	/**
+	 * Stream the whole last HTTP response body into response, HTTP_READ_CHUNK_SIZE bytes at a time.
+	 */
+	bool readHttpResponse(Print& response, ATDataSize dataSize, SIM808HttpTransferReport* report);
+	/**
+	 * Queue a HTTP parameter in the current batch. See beginBatch().
+	 */
+	bool batchHttpParameter(ATConstStr parameter, ATConstStr value);
 #if defined(__AVR__)
-	bool setHttpParameter(ATConstStr parameter, const char * value);
+	bool batchHttpParameter(ATConstStr parameter, const char * value);
 #endif
-	bool setHttpParameter(ATConstStr parameter, uint8_t value);
+	bool batchHttpParameter(ATConstStr parameter, uint8_t value);
 	/**
 	 * Set the HTTP body of the next request to be fired.
 	 */
 	bool setHttpBody(const char* body);
+	/**
+	 * Set the HTTP body of the next request to be fired, reading bodySize bytes from body.
+	 */
+	bool setHttpBody(Stream& body, ATDataSize bodySize);
+	/**
+	 * Set the HTTP body of the next request to be fired, pulling bodySize bytes from producer.
+	 */
+	bool setHttpBody(SIM808HttpBodyProducer producer, ATDataSize bodySize);
+	/**
+	 * Announce a HTTP body of bodySize bytes, and wait for the device to be ready to receive it.
+	 */
+	bool beginHttpBody(ATDataSize bodySize, uint32_t timeout);
+	/**
+	 * Pad the remaining bytes of a body that ran dry, so that the device leaves its download mode
+	 * right away instead of taking the next commands as body until the timeout.
+	 */
+	void abortHttpBody(ATDataSize remaining);
 	/**
 	 * Initialize the HTTP service.
 	 */
@@ -50,12 +142,43 @@ private:
 	 */
 	bool httpEnd();
 	/**
-	 * Set one of the bearer settings for application based on IP.
+	 * Queue one of the bearer settings for application based on IP in the current batch.
 	 */
-	bool setBearerSetting(ATConstStr parameter, const char* value);
+	bool batchBearerSetting(ATConstStr parameter, const char* value);
+	/**
+	 * Queue all the bearer settings needed to open a GPRS bearer in the current batch.
+	 */
+	bool batchBearerSettings(const char* apn, const char* user, const char* password);
+
+	/**
+	 * Open a connection on link, and wait for the remote end to accept it.
+	 */
+	bool socketOpen(uint8_t link, SIM808SocketProtocol protocol, const char* host, uint16_t port);
+	/**
+	 * Send size bytes over link, and wait for the device to accept them.
+	 * If response is provided, returns as soon as the data is written, without waiting for
+	 * the device to accept it : response then receives the responseId() to follow from poll().
+	 */
+	bool socketSend(uint8_t link, const uint8_t* data, size_t size, uint8_t* response = NULL);
+	/**
+	 * Close the connection open on link.
+	 */
+	bool socketClose(uint8_t link);
+	/**
+	 * Wait for a "<link>, <status>" line, and return 0 if status starts with s1, 1 if it starts with s2, or -1.
+	 * s1 and s2 are PROGMEM strings.
+	 */
+	int8_t waitLinkResponse(uint8_t link, uint16_t timeout, const char* s1, const char* s2);
+
+protected:
+	void unhandledLine(const char* line, size_t length);
 
 public:
-	SIM808(uint8_t resetPin, uint8_t pwrKeyPin = SIM808_UNAVAILABLE_PIN, uint8_t statusPin = SIM808_UNAVAILABLE_PIN);
+	/**
+	 * Uses replyBuffer, of replyBufferSize bytes, to hold the lines received.
+	 * See SIM808Buffered for an instance holding its own.
+	 */
+	SIM808(char* replyBuffer, size_t replyBufferSize, uint8_t resetPin, uint8_t pwrKeyPin = SIM808_UNAVAILABLE_PIN, uint8_t statusPin = SIM808_UNAVAILABLE_PIN);
 	~SIM808();	
 
 	/**
@@ -90,7 +213,21 @@ public:
 	bool setSlowClock(SIM808SlowClock mode);
 
 	void init();
+	/**
+	 * Reset the device and wait until it reports every boot phase up to phase, instead of a fixed delay.
+	 * Returns false if phase has not been reached within timeout ms of the serial link being ready.
+	 */
+	bool init(SIM808BootPhase phase, uint16_t timeout);
 	void reset();
+	/**
+	 * Wait until the device has reported every boot phase up to phase, whatever their order.
+	 * Returns false if they have not all been reported within timeout ms.
+	 */
+	bool waitForBoot(SIM808BootPhase phase, uint16_t timeout);
+	/**
+	 * Get the time taken by the device to reach each boot phase since it was last reset or powered on.
+	 */
+	SIM808BootTimings getBootTimings() { return _bootTimings; }
 
 	/**
 	 * Send an already formatted command and read a single line response. Useful for unimplemented commands.
@@ -98,6 +235,19 @@ public:
 	size_t sendCommand(const char* cmd, char* response, size_t responseSize);
 
 	bool setEcho(SIM808Echo mode);
+	/**
+	 * Find the baudrate the device is currently using, trying each supported baudrate
+	 * from the highest. setBaudrate is called to reconfigure the host UART before each attempt,
+	 * and is left at the detected baudrate. Returns 0 if the device never answered.
+	 */
+	uint32_t detectBaudrate(SIM808BaudrateCallback setBaudrate);
+	/**
+	 * Switch the device and the host UART to the highest baudrate up to maxBaudrate at which
+	 * the link proves reliable, falling back to lower baudrates otherwise.
+	 * The baudrate is not saved, and must be negotiated again after each reset. See init().
+	 * Returns the baudrate in use, or 0 if the device could not be reached.
+	 */
+	uint32_t negotiateBaudrate(SIM808BaudrateCallback setBaudrate, uint32_t maxBaudrate = SIM808_MAX_BAUDRATE);
 	/**
 	 * Unlock the SIM card using the provided pin. Beware of failed attempts !
 	 */
@@ -134,10 +284,26 @@ public:
 	 * Shutdown GPRS properly.
 	 */
 	bool disableGprs();
+	/**
+	 * Shutdown any previous connection, and bring the TCP/IP stack up in multi-connection mode,
+	 * so that up to SIM808_MAX_SOCKETS SIM808Socket can be connected at once.
+	 * Uses one of the SIMCOMAT_MAX_URC_HANDLERS unsolicited result code handlers.
+	 * Beware that enableGprs and disableGprs shut every connection down.
+	 */
+	bool openSockets(const char* apn, const char* user = NULL, const char* password = NULL);
+	/**
+	 * Close every connection and shut the TCP/IP stack down.
+	 */
+	bool closeSockets();
 	/**
 	 * Get the device current network registration status.
 	 */
 	SIM808NetworkRegistrationState getNetworkRegistrationStatus();
+	/**
+	 * Configure the network registration unsolicited result code, to be
+	 * received with a handler registered for +CGREG. See registerUrcHandler().
+	 */
+	bool setNetworkRegistrationUrc(SIM808RegistrationUrc mode);
 
 	/**
 	 * Get a boolean indicating wether or not GPS is currently powered on.
@@ -172,6 +338,33 @@ public:
 	 * Get and return the latest GPS parsed sequence.
 	 */
 	bool getGpsPosition(char* response, size_t responseSize);
+	/**
+	 * Get the latest GPS parsed sequence as a typed fix, and a value indicating the current
+	 * fix status. See getGpsStatus.
+	 * The sequence is parsed in a single pass as it is received, whatever its length.
+	 */
+	SIM808GpsStatus getGpsFix(SIM808GnssFix* fix, uint8_t minSatellitesForAccurateFix = GPS_ACCURATE_FIX_MIN_SATELLITES);
+	/**
+	 * Parse a GPS parsed sequence, as returned by getGpsStatus or getGpsPosition, into a typed fix.
+	 */
+	static bool parseGpsFix(const char* response, SIM808GnssFix* fix);
+	/**
+	 * Get a coarse position from the network, based on the surrounding cells (AT+CIPGSMLOC), within seconds
+	 * and without powering GPS on. Requires the GPRS bearer to be open, see enableGprs.
+	 * Only the position, date and time of fix are filled, the run and fix status are left to 0.
+	 */
+	bool getCellLocation(SIM808GnssFix* fix);
+	/**
+	 * Power on GPS if needed, and have the module push a parsed sequence every period fixes (+CGNSURC),
+	 * parsed into stream while it is received. Fixes are handed over while poll, or any command, is
+	 * reading from the module.
+	 * Uses one of the SIMCOMAT_MAX_URC_HANDLERS unsolicited result code handlers.
+	 */
+	bool startGpsStream(SIM808GnssStream& stream, uint8_t period = 1);
+	/**
+	 * Stop pushing parsed sequences, leaving GPS powered on.
+	 */
+	bool stopGpsStream();
 
 
 	/**
@@ -181,12 +374,46 @@ public:
 	 * have a high failure rate that make them unusuable reliably.
 	 */
 	uint16_t httpGet(const char* url, char* response, size_t responseSize);
+	/**
+	 * Send an HTTP GET request and stream the whole server response to response, whatever its size.
+	 * Bytes are written to response as they are received from the device, without any intermediate buffer.
+	 * Details about the transfer are written in report if not NULL.
+	 */
+	uint16_t httpGet(const char* url, Print& response, SIM808HttpTransferReport* report = NULL);
 	/**
 	 * Send an HTTP POST request and read the server response within the limit of responseSize.
 	 * 
 	 * HTTP and HTTPS are supported, based on he provided URL. Note however that HTTPS request
 	 * have a high failure rate that make them unusuable reliably.
 	 */
-	uint16_t httpPost(const char* url, ATConstStr contentType, const char* body, char* response, size_t responseSize);	
+	uint16_t httpPost(const char* url, ATConstStr contentType, const char* body, char* response, size_t responseSize);
+	/**
+	 * Send an HTTP POST request with a body of bodySize bytes read from body, and read the server
+	 * response within the limit of responseSize.
+	 * The body is written to the device as it is read, and never needs to be held in memory at once.
+	 */
+	uint16_t httpPost(const char* url, ATConstStr contentType, Stream& body, ATDataSize bodySize, char* response, size_t responseSize);
+	/**
+	 * Send an HTTP POST request with a body of bodySize bytes pulled from producer, HTTP_WRITE_CHUNK_SIZE
+	 * bytes at a time, and read the server response within the limit of responseSize.
+	 * The body is written to the device as it is produced, and never needs to be held in memory at once.
+	 */
+	uint16_t httpPost(const char* url, ATConstStr contentType, SIM808HttpBodyProducer producer, ATDataSize bodySize, char* response, size_t responseSize);
 };
 
+/**
+ * SIM808 holding a reply buffer of ReplyBufferSize bytes, its only one.
+ * A larger buffer holds whole +CGNSINF sequences without a second read, a smaller one saves RAM on tiny parts.
+ */
+template<uint16_t ReplyBufferSize = SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE>
+class SIM808Buffered : public SIM808
+{
+	static_assert(ReplyBufferSize >= 32, "ReplyBufferSize must be at least 32 bytes");
+
+private:
+	char _storage[ReplyBufferSize];
+
+public:
+	SIM808Buffered(uint8_t resetPin, uint8_t pwrKeyPin = SIM808_UNAVAILABLE_PIN, uint8_t statusPin = SIM808_UNAVAILABLE_PIN) :
+		SIM808(_storage, ReplyBufferSize, resetPin, pwrKeyPin, statusPin) { }
+};
@@ -18,10 +18,29 @@
     #define TO_P(x) x
 #endif
 
+/**
+ * Description of a command, only meant to be passed by value so that it is folded at compile time.
+ * See AT_COMMAND_SPEC.
+ */
+struct ATCommand
+{
+    const char* text;       ///< Fixed part of the command, following AT. PROGMEM.
+    const char* response;   ///< Prefix of the response line, or NULL if the command only answers OK / ERROR. PROGMEM.
+    uint16_t timeout;       ///< Maximum time taken by the device to answer, in ms.
+};
+
 #define TOKEN_TEXT(name, text) const char TOKEN_##name[] S_PROGMEM = text
 #define TOKEN(name) TOKEN_TEXT(name, #name)
 
 #define AT_COMMAND(name, text) const char AT_COMMAND_##name[] S_PROGMEM = text
+/**
+ * Defines AT_name, the description of a command sent with SIMComAT::sendCommandAT.
+ * text is the fixed part of the command, up to its parameters (e.g. "+CGATT="),
+ * response the PROGMEM prefix of its response line, or NULL if it only answers OK / ERROR.
+ */
+#define AT_COMMAND_SPEC(name, text, response, timeout) \
+    const char AT_COMMAND_TEXT_##name[] S_PROGMEM = text; \
+    constexpr ATCommand AT_##name = { AT_COMMAND_TEXT_##name, response, timeout }
 #define AT_COMMAND_PARAMETER(category, name) const char AT_COMMAND_PARAMETER_##category##_##name[] S_PROGMEM = #name
 
 TOKEN(AT);
@@ -0,0 +1,69 @@
+#include "SIMComAT.Ring.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+SIMComATRing::SIMComATRing(uint8_t* buffer, uint16_t size)
+{
+	_buffer = buffer;
+	_mask = size - 1;
+	_head = 0;
+	_tail = 0;
+}
+
+uint16_t SIMComATRing::load(volatile uint16_t& value)
+{
+#if defined(__AVR__)
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { result = value; }
+	return result;
+#else
+	return value;
+#endif
+}
+
+uint16_t SIMComATRing::write(const uint8_t* data, uint16_t size)
+{
+	uint16_t head = _head;
+	uint16_t stored = min(size, (uint16_t)(_mask + 1 - (uint16_t)(head - load(_tail))));
+
+	for(uint16_t i = 0; i < stored; i++) _buffer[(head + i) & _mask] = data[i];
+
+	__sync_synchronize();	// the bytes must be written before being published
+	_head = head + stored;
+	return stored;
+}
+
+uint16_t SIMComATRing::copy(uint8_t* data, uint16_t size, uint16_t offset)
+{
+	uint16_t tail = _tail + offset;
+	uint16_t available = load(_head) - _tail;
+	uint16_t copied = available > offset ? min(size, (uint16_t)(available - offset)) : 0;
+
+	__sync_synchronize();
+	for(uint16_t i = 0; i < copied; i++) data[i] = _buffer[(tail + i) & _mask];
+
+	return copied;
+}
+
+void SIMComATRing::release(uint16_t size)
+{
+	__sync_synchronize();	// the bytes must be read before their space is handed back
+	_tail = _tail + size;
+}
+
+int SIMComATRing::peek()
+{
+	uint8_t c;
+	return copy(&c, 1) ? c : -1;
+}
+
+int SIMComATRing::read()
+{
+	uint8_t c;
+	if(!copy(&c, 1)) return -1;
+
+	release(1);
+	return c;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Byte ring shared by the receive ring, the fix ring and the sockets. Lock free for one producer and one consumer :
+ * the producer writes bytes then publishes them, the consumer copies them then releases their space.
+ *
+ * The bytes are stored in a caller provided buffer, whose size must be a power of two
+ * of at most 32768 bytes.
+ */
+class SIMComATRing
+{
+private:
+	uint8_t* _buffer;
+	uint16_t _mask;
+	volatile uint16_t _head;	///< Written by the producer only.
+	volatile uint16_t _tail;	///< Written by the consumer only.
+
+public:
+	SIMComATRing(uint8_t* buffer, uint16_t size);
+
+	/**
+	 * Read an index written by the other side of a ring. 16 bits loads are not atomic on AVR.
+	 */
+	static uint16_t load(volatile uint16_t& value);
+
+	/**
+	 * Get the size of the ring, in bytes.
+	 */
+	uint16_t capacity() { return _mask + 1; }
+	/**
+	 * Get the number of bytes published and not released yet.
+	 */
+	uint16_t used() { return load(_head) - load(_tail); }
+	uint16_t free() { return capacity() - used(); }
+
+	/**
+	 * Store at most size bytes, as many as there is room for, and publish them at once. Producer side.
+	 * Returns the number of bytes stored.
+	 */
+	uint16_t write(const uint8_t* data, uint16_t size);
+	/**
+	 * Copy at most size bytes, starting offset bytes after the oldest one, without releasing them. Consumer side.
+	 * Returns the number of bytes copied.
+	 */
+	uint16_t copy(uint8_t* data, uint16_t size, uint16_t offset = 0);
+	/**
+	 * Hand the space of the size oldest bytes back to the producer. Consumer side.
+	 */
+	void release(uint16_t size);
+	/**
+	 * Get the oldest byte, or -1 if the ring is empty. Consumer side.
+	 */
+	int peek();
+	/**
+	 * Get and release the oldest byte, or -1 if the ring is empty. Consumer side.
+	 */
+	int read();
+	/**
+	 * Release every byte published so far. Consumer side.
+	 */
+	void clear() { _tail = load(_head); }
+};
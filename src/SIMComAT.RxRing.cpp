@@ -0,0 +1,73 @@
+#include "SIMComAT.RxRing.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+SIMComATRxRing::SIMComATRxRing(uint8_t* buffer, uint16_t size) : _ring(buffer, size)
+{
+	_highWater = 0;
+	_overflows = 0;
+}
+
+bool SIMComATRxRing::push(uint8_t c)
+{
+	return push(&c, 1) == 1;
+}
+
+size_t SIMComATRxRing::push(const uint8_t* data, size_t size)
+{
+	uint16_t stored = _ring.write(data, min(size, (size_t)_ring.capacity()));
+	uint16_t used = _ring.used();
+
+	if(used > _highWater) _highWater = used;
+	_overflows += size - stored;
+
+	return stored;
+}
+
+size_t SIMComATRxRing::fill(Stream& port)
+{
+	size_t moved = 0;
+
+	while(port.available() && push((uint8_t)port.read())) moved++;
+	return moved;
+}
+
+int SIMComATRxRing::available()
+{
+	return _ring.used();
+}
+
+int SIMComATRxRing::read()
+{
+	return _ring.read();
+}
+
+int SIMComATRxRing::peek()
+{
+	return _ring.peek();
+}
+
+uint16_t SIMComATRxRing::highWaterMark()
+{
+	return SIMComATRing::load(_highWater);
+}
+
+uint16_t SIMComATRxRing::overflows()
+{
+	return SIMComATRing::load(_overflows);
+}
+
+void SIMComATRxRing::resetStatistics()
+{
+#if defined(__AVR__)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_highWater = 0;
+		_overflows = 0;
+	}
+#else
+	_highWater = 0;
+	_overflows = 0;
+#endif
+}
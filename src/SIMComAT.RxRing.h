@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SIMComAT.Ring.h"
+
+/**
+ * Receive ring owned by the library, filled by the sketch from a UART interrupt, a DMA completion
+ * or a periodic task, and consumed by the parser instead of the port own buffer. See SIMComAT::begin.
+ * Lock free for one producer and one consumer.
+ *
+ * The bytes are stored in a caller provided buffer, whose size must be a power of two
+ * of at most 32768 bytes. See SIMComATStaticRxRing.
+ */
+class SIMComATRxRing
+{
+private:
+	SIMComATRing _ring;
+	volatile uint16_t _highWater;	///< Written by the producer only.
+	volatile uint16_t _overflows;	///< Written by the producer only.
+
+public:
+	SIMComATRxRing(uint8_t* buffer, uint16_t size);
+
+	/**
+	 * Store a received byte. Safe to call from an interrupt.
+	 * Returns false, dropping the byte, if the ring is full.
+	 */
+	bool push(uint8_t c);
+	/**
+	 * Store size received bytes at once, typically from a DMA completion. Safe to call from an interrupt.
+	 * Returns the number of bytes stored, the others being dropped.
+	 */
+	size_t push(const uint8_t* data, size_t size);
+	/**
+	 * Move the bytes waiting in port into the ring, for ports without an interrupt hook.
+	 * Returns the number of bytes moved.
+	 */
+	size_t fill(Stream& port);
+
+	int available();
+	int read();
+	int peek();
+
+	/**
+	 * Get the size of the ring, in bytes.
+	 */
+	uint16_t capacity() { return _ring.capacity(); }
+	/**
+	 * Get the highest number of bytes held at once since the statistics were reset.
+	 */
+	uint16_t highWaterMark();
+	/**
+	 * Get the number of bytes dropped because the ring was full since the statistics were reset.
+	 */
+	uint16_t overflows();
+	void resetStatistics();
+};
+
+/**
+ * SIMComATRxRing storing its bytes in Size bytes of its own.
+ */
+template<uint16_t Size>
+class SIMComATStaticRxRing : public SIMComATRxRing
+{
+	static_assert(Size && !(Size & (Size - 1)) && Size <= 32768, "Size must be a power of two of at most 32768");
+
+private:
+	uint8_t _storage[Size];
+
+public:
+	SIMComATStaticRxRing() : SIMComATRxRing(_storage, Size) { }
+};
@@ -0,0 +1,169 @@
+#include "SIMComAT.h"
+
+#if SIMCOMAT_STATS
+
+static uint8_t bucket(uint32_t duration)
+{
+	uint8_t index = 0;
+
+	while(duration && index < SIMCOMAT_STATS_BUCKETS - 1) {
+		duration >>= 1;
+		index++;
+	}
+
+	return index;
+}
+
+static void writeLittleEndian(Print& output, uint32_t value, uint8_t size)
+{
+	for(uint8_t i = 0; i < size; i++) {
+		output.write((uint8_t)value);
+		value >>= 8;
+	}
+}
+
+/**
+ * Write a PROGMEM string as a quoted CSV field, commands such as +CIPSTART="TCP" holding quotes and commas.
+ */
+static void writeCsvField(Print& output, const char* value)
+{
+	char c;
+
+	output.print('"');
+	while(value && (c = pgm_read_byte(value++))) {
+		if(c == '"') output.print('"');
+		output.print(c);
+	}
+	output.print('"');
+}
+
+SIMComATStats::SIMComATStats()
+{
+	reset();
+}
+
+void SIMComATStats::reset()
+{
+	memset(_entries, 0, sizeof(_entries));
+	_active = false;
+	_queuedKey = NULL;
+}
+
+void SIMComATStats::begin(const char* key)
+{
+	if(_active) commit();
+
+	_key = key;
+	_active = true;
+	_gotFirstByte = false;
+	_responded = false;
+	_timedOut = false;
+	_errored = false;
+	_start = millis();
+	_sent = 0;
+	_received = 0;
+	_receivedAtResult = 0;
+}
+
+void SIMComATStats::received(int c)
+{
+	if(!_active || c < 0) return;
+
+	if(!_gotFirstByte) {
+		_firstByte = millis() - _start;
+		_gotFirstByte = true;
+	}
+
+	_received++;
+}
+
+void SIMComATStats::result(bool timeout, bool error)
+{
+	if(!_active) return;
+
+	// a command might wait for several responses, the last one is kept
+	_result = millis() - _start;
+	_receivedAtResult = _received;
+	_responded = true;
+	_timedOut |= timeout;
+	_errored |= error;
+}
+
+SIMComATCommandStats* SIMComATStats::entry(const char* key)
+{
+	if(key) {
+		for(uint8_t i = 0; i < SIMCOMAT_STATS_COMMANDS - 1; i++) {
+			if(!_entries[i].count) {
+				_entries[i].command = key;
+				return &_entries[i];
+			}
+
+			if(_entries[i].command == key) return &_entries[i];
+		}
+	}
+
+	return &_entries[SIMCOMAT_STATS_COMMANDS - 1];
+}
+
+void SIMComATStats::commit()
+{
+	SIMComATCommandStats* stats = entry(_key);
+
+	_active = false;
+
+	stats->count++;
+	stats->sent += _sent;
+	stats->received += _responded ? _receivedAtResult : _received;
+	if(_timedOut) stats->timeouts++;
+	if(_errored) stats->errors++;
+	if(_gotFirstByte) stats->firstByte[bucket(_firstByte)]++;
+	if(_responded) stats->result[bucket(_result)]++;
+}
+
+void SIMComATStats::dump(Print& output, SIMComATStatsFormat format)
+{
+	if(_active) commit();
+
+	if(format == SIMComATStatsFormat::Csv) {
+		output.print(F("command,count,timeouts,errors,sent,received"));
+		for(uint8_t i = 0; i < SIMCOMAT_STATS_BUCKETS; i++) { output.print(F(",f")); output.print(i); }
+		for(uint8_t i = 0; i < SIMCOMAT_STATS_BUCKETS; i++) { output.print(F(",r")); output.print(i); }
+		output.println();
+	}
+
+	for(uint8_t i = 0; i < SIMCOMAT_STATS_COMMANDS; i++) {
+		SIMComATCommandStats& stats = _entries[i];
+		if(!stats.count) continue;
+
+		if(format == SIMComATStatsFormat::Binary) {
+			if(stats.command) output.print(TO_F(stats.command));
+			output.write((uint8_t)0);
+
+			writeLittleEndian(output, stats.count, 2);
+			writeLittleEndian(output, stats.timeouts, 2);
+			writeLittleEndian(output, stats.errors, 2);
+			writeLittleEndian(output, stats.sent, 4);
+			writeLittleEndian(output, stats.received, 4);
+			for(uint8_t j = 0; j < SIMCOMAT_STATS_BUCKETS; j++) writeLittleEndian(output, stats.firstByte[j], 2);
+			for(uint8_t j = 0; j < SIMCOMAT_STATS_BUCKETS; j++) writeLittleEndian(output, stats.result[j], 2);
+			continue;
+		}
+
+		writeCsvField(output, stats.command);
+		output.print(',');
+		output.print(stats.count);
+		output.print(',');
+		output.print(stats.timeouts);
+		output.print(',');
+		output.print(stats.errors);
+		output.print(',');
+		output.print(stats.sent);
+		output.print(',');
+		output.print(stats.received);
+		for(uint8_t j = 0; j < SIMCOMAT_STATS_BUCKETS; j++) { output.print(','); output.print(stats.firstByte[j]); }
+		for(uint8_t j = 0; j < SIMCOMAT_STATS_BUCKETS; j++) { output.print(','); output.print(stats.result[j]); }
+		output.println();
+	}
+}
+
+#endif // SIMCOMAT_STATS
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+
+#if SIMCOMAT_STATS
+
+#define SIMCOMAT_STATS_BUCKETS 16	///< Buckets of each latency histogram.
+
+/**
+ * Format of SIMComAT::dumpStats output.
+ */
+enum class SIMComATStatsFormat : uint8_t
+{
+	/**
+	 * A header line, then one line per command : command,count,timeouts,errors,sent,received,
+	 * followed by the time to first byte buckets (f0 to f15) and the time to result buckets (r0 to r15).
+	 * The command is quoted, its own quotes doubled, and empty for the entry gathering the other commands.
+	 */
+	Csv = 0,
+	/**
+	 * One record per command : the command NUL terminated, count, timeouts and errors as uint16_t,
+	 * sent and received as uint32_t, then both histograms as uint16_t, all little endian.
+	 */
+	Binary = 1
+};
+
+/**
+ * Statistics aggregated for every command sharing the same text.
+ * Histogram bucket 0 counts latencies under 1 ms, bucket i latencies from 2^(i-1) ms to 2^i ms,
+ * and the last bucket everything above.
+ */
+struct SIMComATCommandStats
+{
+	const char* command;		///< PROGMEM text of the command, or NULL for the commands that did not get their own entry.
+	uint16_t count;				///< Number of times the command has been sent.
+	uint16_t timeouts;			///< Responses that timed out.
+	uint16_t errors;			///< Responses that were an error.
+	uint32_t sent;				///< Bytes sent, command lines and data.
+	uint32_t received;			///< Bytes received up to the last response.
+	uint16_t firstByte[SIMCOMAT_STATS_BUCKETS];	///< Time from the command to the first byte received.
+	uint16_t result[SIMCOMAT_STATS_BUCKETS];	///< Time from the command to its last response.
+};
+
+/**
+ * Records the exchange of each command with the device, and aggregates it once the next command is sent.
+ */
+class SIMComATStats
+{
+private:
+	SIMComATCommandStats _entries[SIMCOMAT_STATS_COMMANDS];
+	const char* _key;
+	const char* _queuedKey;
+	bool _active;
+	bool _gotFirstByte;
+	bool _responded;
+	bool _timedOut;
+	bool _errored;
+	uint32_t _start;
+	uint32_t _firstByte;
+	uint32_t _result;
+	uint32_t _sent;
+	uint32_t _received;
+	uint32_t _receivedAtResult;
+
+	/**
+	 * Aggregate the command being recorded into its entry.
+	 */
+	void commit();
+	SIMComATCommandStats* entry(const char* key);
+
+public:
+	SIMComATStats();
+
+	/**
+	 * Start recording a command, identified by its PROGMEM text.
+	 */
+	void begin(const char* key);
+	/**
+	 * Remember the key of the last command queued in a batch, recorded once its line is started.
+	 */
+	void queue(const char* key) { _queuedKey = key; }
+	void beginQueued() { begin(_queuedKey); }
+	void sent(size_t count) { _sent += count; }
+	void received(int c);
+	void result(bool timeout, bool error);
+
+	/**
+	 * Forget everything recorded so far.
+	 */
+	void reset();
+	/**
+	 * Write the statistics of every command sent so far to output.
+	 */
+	void dump(Print& output, SIMComATStatsFormat format);
+};
+
+#endif // SIMCOMAT_STATS
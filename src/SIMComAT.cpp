@@ -1,19 +1,101 @@
 #include "SIMComAT.h"
 #include <errno.h>
 
+TOKEN_TEXT(CME_ERROR, "+CME ERROR");
+TOKEN_TEXT(CMS_ERROR, "+CMS ERROR");
+TOKEN_TEXT(NO_CARRIER, "NO CARRIER");
+TOKEN_TEXT(NO_DIALTONE, "NO DIALTONE");
+TOKEN_TEXT(NO_ANSWER, "NO ANSWER");
+TOKEN_TEXT(BUSY, "BUSY");
+TOKEN_TEXT(SEND_FAIL, "SEND FAIL");
+
+#define FINAL_ERRORS_COUNT 8
+
+/**
+ * Final result codes ending a command in failure, whatever response is awaited.
+ */
+const char* const FINAL_ERRORS[FINAL_ERRORS_COUNT] S_PROGMEM = {
+	TOKEN_ERROR,
+	TOKEN_CME_ERROR,
+	TOKEN_CMS_ERROR,
+	TOKEN_NO_CARRIER,
+	TOKEN_NO_DIALTONE,
+	TOKEN_NO_ANSWER,
+	TOKEN_BUSY,
+	TOKEN_SEND_FAIL
+};
+
+SIMComAT::SIMComAT(char* replyBuffer, size_t replyBufferSize)
+{
+	this->replyBuffer = replyBuffer;
+	this->replyBufferSize = replyBufferSize;
+
+	_wantedMask = 0;
+	_urcMask = 0;
+	_lineLength = 0;
+	_lineCandidates = 0;
+	_lineMatches = 0;
+	_responseResult = -1;
+	_errorCode = -1;
+	_responseStatus = SIMComATResponseStatus::Idle;
+	_responseCallback = NULL;
+	_responseId = 0;
+	_batchLength = 0;
+	_batchFailed = false;
+	_measuring = false;
+	_txLength = 0;
+
+	_lineOutput = NULL;
+	_dataOutput = NULL;
+	_dataRemaining = 0;
+
+	for(uint8_t i = 0; i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+		_urcPrefixes[i] = NULL;
+		_urcHandlers[i] = NULL;
+		_urcOutputs[i] = NULL;
+	}
+}
+
 void SIMComAT::begin(Stream& port)
 {
 	_port = &port;
-	_output.begin(LOG_LEVEL_VERBOSE, this, false);
+	_rxRing = NULL;
 #if _SIM808_DEBUG
 	_debug.begin(LOG_LEVEL_VERBOSE, &Serial, false);
 #endif // _SIM808_DEBUG
 }
 
+void SIMComAT::begin(Stream& port, SIMComATRxRing& rxRing)
+{
+	begin(port);
+	_rxRing = &rxRing;
+}
+
+size_t SIMComAT::write(const uint8_t* buffer, size_t size)
+{
+	if(_measuring) {
+		_measured += size;
+		return size;
+	}
+
+	SIMCOMAT_STATS_SENT(size);
+	if(_txLength + size > SIMCOMAT_TX_BUFFER_SIZE) flushTx();
+
+	// payloads too large to be coalesced are written as is
+	if(size >= SIMCOMAT_TX_BUFFER_SIZE) {
+		SIM808_PRINT_BYTES(buffer, size);
+		return _port->write(buffer, size);
+	}
+
+	memcpy(_txBuffer + _txLength, buffer, size);
+	_txLength += size;
+	if(size && buffer[size - 1] == '\n') flushTx();
+
+	return size;
+}
+
 void SIMComAT::flushInput() {
-	uint16_t timeout = 0;
-	while(readNext(replyBuffer, BUFFER_SIZE, &timeout));
-	memset(replyBuffer, 0, BUFFER_SIZE);
+	readLines();
 }
 
 
@@ -21,6 +103,8 @@ size_t SIMComAT::readNext(char * buffer, size_t size, uint16_t * timeout, char s
 {
 	size_t i = 0;
 	bool exit = false;
+	uint32_t start = millis();
+	uint16_t elapsed = 0;
 
 	do {
 		while(!exit && i < size - 1 && available()) {
@@ -31,16 +115,14 @@ size_t SIMComAT::readNext(char * buffer, size_t size, uint16_t * timeout, char s
 			exit |= stop && c == stop;
 		}
 
-		if(timeout) {			
-			if(*timeout) {
-				delay(1);
-				(*timeout)--;
-			}
-
-			if(!(*timeout)) break;
+		if(timeout) {
+			elapsed = millis() - start;
+			if(elapsed >= *timeout) break;
+			yield();
 		}
 	} while(!exit && i < size - 1);
 
+	if(timeout) *timeout = elapsed >= *timeout ? 0 : *timeout - elapsed;
 	buffer[i] = '\0';
 
 	if(i) {
@@ -51,39 +133,478 @@ size_t SIMComAT::readNext(char * buffer, size_t size, uint16_t * timeout, char s
 	return i > 0 ? i - 1 : i;
 }
 
-int8_t SIMComAT::waitResponse(uint16_t timeout, 
-	ATConstStr s1, 
+size_t SIMComAT::readNext(Print& output, size_t size, uint16_t timeout, char stop)
+{
+	size_t i = 0;
+	uint32_t last = millis();
+
+	while(i < size && millis() - last < timeout) {
+		if(!available()) {
+			yield();
+			continue;
+		}
+
+		char c = read();
+		output.write((uint8_t)c);
+		last = millis();
+		i++;
+
+		if(stop && c == stop) break;
+	}
+
+	return i;
+}
+
+void SIMComAT::beginResponse(uint16_t timeout,
+	ATConstStr s1,
 	ATConstStr s2,
 	ATConstStr s3,
 	ATConstStr s4)
 {
-	ATConstStr wantedTokens[4] = { s1, s2, s3, s4 };
-	size_t length;
+	_wantedTokens[0] = s1;
+	_wantedTokens[1] = s2;
+	_wantedTokens[2] = s3;
+	_wantedTokens[3] = s4;
+
+	_responseStart = millis();
+	_responseTimeout = timeout;
+	_responseResult = -1;
+	_errorCode = -1;
+	_responseStatus = SIMComATResponseStatus::Pending;
+	_responseCallback = NULL;
+	_responseId++;
+	_wantedMask = 0;
+
+	if(s1 != NULL) {	//otherwise looking for a line with any content, nothing to match
+		for(uint8_t i = 0; i < 4; i++) {
+			if(_wantedTokens[i]) _wantedMask |= 1 << i;
+		}
+	}
 
-	do {
-		memset(replyBuffer, 0, BUFFER_SIZE);
-		length = readNext(replyBuffer, BUFFER_SIZE, &timeout, '\n');
+	// a line already partially read cannot be the response, but might still be an unsolicited one
+	if(!_lineLength) _lineCandidates = _wantedMask | _urcMask;
+
+	// the response only comes once the command is completely sent
+	flushTx();
+}
+
+SIMComATResponseStatus SIMComAT::pollResponse()
+{
+	if(_responseStatus != SIMComATResponseStatus::Pending) return _responseStatus;
 
-		if(!length) continue; 					//read nothing
-		if(wantedTokens[0] == NULL) return 0;	//looking for a line with any content
+	int8_t result = readLines();
+	if(result != -1) return endResponse(SIMComATResponseStatus::Done, result);
 
-		for(uint8_t i = 0; i < 4; i++) {
-			if(wantedTokens[i]) {
-				char *p = strstr_P(replyBuffer, TO_P(wantedTokens[i]));
-				if(replyBuffer == p) return i;				
+	if(millis() - _responseStart < _responseTimeout) return SIMComATResponseStatus::Pending;
+
+	// timeout is exhausted, the partial line is the last chance to match
+	result = endLine();
+	return result != -1 ?
+		endResponse(SIMComATResponseStatus::Done, result) :
+		endResponse(SIMComATResponseStatus::Timeout, -1);
+}
+
+int8_t SIMComAT::readLines()
+{
+	int count;
+
+	// reading what is already waiting, without asking the port again before each character
+	while((count = available()) > 0) {
+		while(count--) {
+			int next = read();
+			if(next < 0) break;	//a handler read from the port meanwhile
+
+			char c = next;
+
+			if(_dataRemaining) {
+				_dataRemaining--;
+				_dataOutput->write((uint8_t)c);
+				continue;
 			}
+
+			if(_lineOutput) {
+				_lineOutput->write((uint8_t)c);
+				if(c == '\n') endLine();
+				continue;
+			}
+
+			if(_lineCandidates) matchNext(c);
+			replyBuffer[_lineLength++] = c;
+
+			if(_lineMatches >> 4 && !((_lineCandidates | _lineMatches) & 0x0F)) {
+				// an unsolicited line has been recognized, redirecting the rest of it if needed
+				for(uint8_t i = 0; !_lineOutput && i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+					if(_lineMatches & (1 << (i + 4))) _lineOutput = _urcOutputs[i];
+				}
+			}
+
+			if(c != '\n' &&
+				_lineLength < replyBufferSize - 1 &&
+				!(_lineLength == 2 && replyBuffer[0] == '>' && c == ' ')) continue; //line is not complete yet, unless it is a data prompt
+
+			int8_t result = endLine();
+			if(result != -1) return result;
+		}
+	}
+
+	return -1;
+}
+
+void SIMComAT::matchNext(char c)
+{
+	for(uint8_t i = 0; _lineCandidates >> i; i++) {
+		uint16_t bit = 1 << i;
+		if(!(_lineCandidates & bit)) continue;
+
+		const char *token = TO_P(lineToken(i)) + _lineLength;
+		if(pgm_read_byte(token) != c) _lineCandidates &= ~bit;
+		else if(!pgm_read_byte(token + 1)) {
+			// the whole token has been matched
+			_lineCandidates &= ~bit;
+			_lineMatches |= bit;
 		}
-	} while(timeout);
+	}
+}
+
+int8_t SIMComAT::endLine()
+{
+	size_t length = _lineLength;
+	uint16_t matches = _lineMatches;
+
+	replyBuffer[length] = '\0';
+	_lineLength = 0;
+	_lineMatches = 0;
+	_lineCandidates = _wantedMask | _urcMask;
+	_lineOutput = NULL;
+
+	if(length < 2) return -1;					//read nothing
+
+	RECEIVEARROW;
+	SIM808_PRINT(replyBuffer);
+
+	for(uint8_t i = 0; i < 4; i++) {
+		if(matches & (1 << i)) return i;
+	}
+
+	for(uint8_t i = 0; i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+		if(!(matches & (1 << (i + 4)))) continue;
+		if(!_urcHandlers[i]) return -1;	//already redirected to an output
+
+		// handing the line over without its new line, in place
+		length = trimLine(length);
+		_urcHandlers[i](replyBuffer, length);
+		return -1;
+	}
+
+	if(_responseStatus == SIMComATResponseStatus::Pending) {
+		if(isFinalError()) return SIMCOMAT_RESULT_FAILED;
+		if(_wantedTokens[0] == NULL) return 0;	//looking for a line with any content
+	}
+
+	length = trimLine(length);
+	if(length) unhandledLine(replyBuffer, length);
 
 	return -1;
 }
 
+bool SIMComAT::isFinalError()
+{
+	for(uint8_t i = 0; i < FINAL_ERRORS_COUNT; i++) {
+		const char* token = (const char*)pgm_read_ptr(&FINAL_ERRORS[i]);
+		// most lines are told apart by their first character, without a full comparison
+		if(pgm_read_byte(token) != replyBuffer[0] || strncmp_P(replyBuffer, token, strlen_P(token))) continue;
+
+		// +CME ERROR: <n>, +CMS ERROR: <n>
+		char* code = strchr(replyBuffer, ':');
+		if(code != NULL && code[1] != '\0' && code[2] >= '0' && code[2] <= '9') _errorCode = atoi(code + 2);
+
+		return true;
+	}
+
+	return false;
+}
+
+size_t SIMComAT::trimLine(size_t length)
+{
+	while(length && (replyBuffer[length - 1] == '\n' || replyBuffer[length - 1] == '\r')) length--;
+	replyBuffer[length] = '\0';
+
+	return length;
+}
+
+void SIMComAT::receiveData(Print& output, size_t length)
+{
+	_dataOutput = &output;
+	_dataRemaining = length;
+}
+
+SIMComATResponseStatus SIMComAT::endResponse(SIMComATResponseStatus status, int8_t result)
+{
+	SIMComATResponseCallback callback = _responseCallback;
+
+	SIMCOMAT_STATS_RESULT(status == SIMComATResponseStatus::Timeout,
+		result == SIMCOMAT_RESULT_FAILED || (result == 1 && _wantedTokens[1] == TO_F(TOKEN_ERROR)));
+
+	_wantedMask = 0;
+	_lineCandidates = _urcMask;
+	_responseResult = result;
+	_responseStatus = status;
+	_responseCallback = NULL;
+
+	if(callback) callback(result);
+	return status;
+}
+
+int8_t SIMComAT::waitResponse(uint16_t timeout, 
+	ATConstStr s1, 
+	ATConstStr s2,
+	ATConstStr s3,
+	ATConstStr s4)
+{
+	beginResponse(timeout, s1, s2, s3, s4);
+	while(pollResponse() == SIMComATResponseStatus::Pending) yield();
+
+	return _responseResult;
+}
+
+bool SIMComAT::sendCommandAsync(const char* cmd, SIMComATResponseCallback callback, uint16_t timeout)
+{
+	if(_responseStatus == SIMComATResponseStatus::Pending) return false;
+
+	sendRawAT(cmd);
+	beginResponse(timeout);
+	_responseCallback = callback;
+
+	return true;
+}
+
+SIMComATResponseStatus SIMComAT::poll()
+{
+	if(_responseStatus == SIMComATResponseStatus::Pending) return pollResponse();
+
+	readLines();
+	return _responseStatus;
+}
+
+bool SIMComAT::registerUrcHandler(ATConstStr prefix, SIMComATUrcHandler handler)
+{
+	for(uint8_t i = 0; i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+		if(_urcPrefixes[i]) continue;
+
+		_urcPrefixes[i] = prefix;
+		_urcHandlers[i] = handler;
+		_urcMask |= 1 << (i + 4);
+		return true;
+	}
+
+	return false;
+}
+
+bool SIMComAT::registerUrcHandler(ATConstStr prefix, Print& output)
+{
+	for(uint8_t i = 0; i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+		if(_urcPrefixes[i]) continue;
+
+		_urcPrefixes[i] = prefix;
+		_urcOutputs[i] = &output;
+		_urcMask |= 1 << (i + 4);
+		return true;
+	}
+
+	return false;
+}
+
+void SIMComAT::unregisterUrcHandler(ATConstStr prefix)
+{
+	for(uint8_t i = 0; i < SIMCOMAT_MAX_URC_HANDLERS; i++) {
+		if(_urcPrefixes[i] != prefix) continue;
+
+		if(_lineOutput == _urcOutputs[i]) _lineOutput = NULL;
+
+		_urcMask &= ~(1 << (i + 4));
+		_lineCandidates &= ~(1 << (i + 4));
+		_lineMatches &= ~(1 << (i + 4));
+		_urcPrefixes[i] = NULL;
+		_urcHandlers[i] = NULL;
+		_urcOutputs[i] = NULL;
+	}
+}
+
+void SIMComAT::beginBatch(uint16_t timeout)
+{
+	_batchLength = 0;
+	_batchTimeout = timeout;
+	_batchFailed = false;
+}
+
+bool SIMComAT::nextBatchCommand(size_t length)
+{
+	if(_batchFailed) return false;
+	// room for the separator and the new line
+	if(_batchLength && _batchLength + length + 2 > SIMCOMAT_MAX_COMMAND_LINE && !sendBatchLine()) return false;
+
+	if(_batchLength) {
+		print(';');
+		_batchLength++;
+	}
+	else {
+		SIMCOMAT_STATS_LINE();
+		SENDARROW;
+		writeStream(TO_F(TOKEN_AT));
+		_batchLength = strlen_P(TOKEN_AT);
+	}
+
+	_batchLength += length;
+	return true;
+}
+
+bool SIMComAT::sendBatchLine()
+{
+	writeStream(TO_F(TOKEN_NL));
+	_batchLength = 0;
+
+	// the device stops at the first failing command of the line and only answers ERROR
+	_batchFailed = waitResponse(_batchTimeout) != 0;
+	return !_batchFailed;
+}
+
+bool SIMComAT::endBatch()
+{
+	if(_batchLength) sendBatchLine();
+	return !_batchFailed;
+}
+
+bool SIMComAT::endBatchAsync()
+{
+	if(_batchFailed || !_batchLength) return false;
+
+	writeStream(TO_F(TOKEN_NL));
+	_batchLength = 0;
+
+	beginResponse(_batchTimeout);
+	return true;
+}
+
+void SIMComAT::sendFormatAT(ATConstStr format, ...)
+{
+	SIMComATLine line(*this);
+	va_list args;
+
+	SIMCOMAT_STATS_BEGIN(TO_P(format));
+	SENDARROW;
+	line.append_P(TOKEN_AT);
+
+	va_start(args, format);
+	writeFormat(line, format, args);
+	va_end(args);
+
+	line.append_P(TOKEN_NL);
+	line.flush();
+}
+
+bool SIMComAT::batchFormatAT(ATConstStr format, ...)
+{
+	SIMComATLine line(*this);
+	va_list args;
+	va_list measured;
+	bool result;
+
+	va_start(args, format);
+	va_copy(measured, args);
+
+	_measured = 0;
+	_measuring = true;
+	writeFormat(line, format, measured);
+	line.flush();
+	_measuring = false;
+	va_end(measured);
+
+	SIMCOMAT_STATS_QUEUE(TO_P(format));
+	result = nextBatchCommand(_measured);
+	if(result) {
+		writeFormat(line, format, args);
+		line.flush();
+	}
+
+	va_end(args);
+	return result;
+}
+
+void SIMComAT::writeFormat(SIMComATLine& line, ATConstStr format, va_list args)
+{
+	const char* p = TO_P(format);
+	char c;
+
+	while((c = pgm_read_byte(p++))) {
+		if(c != '%') {
+			line.append(c);
+			continue;
+		}
+
+		switch(c = pgm_read_byte(p++)) {
+			case 'd': line.appendNumber(va_arg(args, int)); break;
+			case 'l': line.appendNumber(va_arg(args, long)); break;
+			case 's': line.append(va_arg(args, const char*)); break;
+			case 'S': line.append_P(va_arg(args, const char*)); break;
+			case '\0': return;
+			default: line.append(c);
+		}
+	}
+}
+
+void SIMComAT::writeParameter(SIMComATLine& line, const char* value)
+{
+	line.append('"');
+	line.append(value);
+	line.append('"');
+}
+
+#if defined(__AVR__)
+void SIMComAT::writeParameter(SIMComATLine& line, ATConstStr value)
+{
+	line.append('"');
+	line.append_P(TO_P(value));
+	line.append('"');
+}
+#endif
+
+void SIMComATLine::append(const char* str)
+{
+	while(*str) append(*str++);
+}
+
+void SIMComATLine::append_P(const char* str)
+{
+	char c;
+	while((c = pgm_read_byte(str++))) append(c);
+}
+
+void SIMComATLine::appendUnsigned(uint32_t value)
+{
+	char digits[10];
+	uint8_t count = 0;
+
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while(value);
+
+	while(count) append(digits[--count]);
+}
+
+void SIMComATLine::flush()
+{
+	if(_length) _output->write((const uint8_t*)_buffer, _length);
+	_length = 0;
+}
+
 size_t SIMComAT::copyCurrentLine(char *dst, size_t dstSize, uint16_t shift)
 {
 	char *p = dst;
 	char *p1;
 	
-	p += safeCopy(replyBuffer + shift, p, dstSize); // copy the current buffer content	
+	// copy the current buffer content, as much as fits
+	p += min(safeCopy(replyBuffer + shift, p, dstSize), dstSize - 1);
 	// copy the rest of the line if any
 	if(!strchr(dst, '\n')) p += readNext(p, dstSize - (p - dst), NULL, '\n');
 
@@ -108,7 +629,7 @@ size_t SIMComAT::safeCopy(const char *src, char *dst, size_t dstSize)
 
 char* SIMComAT::find(const char* str, char divider, uint8_t index)
 {
-	char* p = strchr(str, ':');
+	const char* p = strchr(str, ':');
 	if (p == NULL) p = strchr(str, str[0]); //ditching eventual response header
 
 	p++;
@@ -119,7 +640,36 @@ char* SIMComAT::find(const char* str, char divider, uint8_t index)
 		p++;
 	}
 
-	return p;
+	// like strchr, hands the field back as mutable
+	return (char*)p;
+}
+
+bool SIMComAT::parseField(const char*& p, char divider, bool* negative, uint32_t* value)
+{
+	uint8_t digits = 0;
+
+	if(p == NULL) return false;
+
+	while(*p == ' ') p++;
+
+	*negative = *p == '-';
+	if(*negative) p++;
+
+	*value = 0;
+	for(; *p >= '0' && *p <= '9'; p++, digits++) {
+		uint8_t digit = *p - '0';
+		if(*value > (UINT32_MAX - digit) / 10) return false;
+
+		*value = *value * 10 + digit;
+	}
+
+	while(*p == ' ' || *p == '\r' || *p == '\n') p++;
+
+	if(*p == divider) p++;
+	else if(*p == '\0') p = NULL;
+	else return false;
+
+	return digits != 0;
 }
 
 bool SIMComAT::parse(const char* str, char divider, uint8_t index, uint8_t* result)
@@ -163,6 +713,19 @@ bool SIMComAT::parse(const char* str, char divider, uint8_t index, size_t* resul
 }
 #endif
 
+#if defined(NEED_DATA_SIZE_OVERLOADS)
+bool SIMComAT::parse(const char* str, char divider, uint8_t index, ATDataSize* result)
+{
+	char* p = find(str, divider, index);
+	if (p == NULL) return false;
+
+	errno = 0;
+	*result = strtoul(p, NULL, 10);
+
+	return errno == 0;
+}
+#endif
+
 bool SIMComAT::parse(const char* str, char divider, uint8_t index, int16_t* result)
 {	
 	char* p = find(str, divider, index);
@@ -1,14 +1,26 @@
 #pragma once
 
 #include <Arduino.h>
-#include <ArduinoLog.h>
+#include <stdarg.h>
 #include "SIMComAT.Common.h"
+#include "SIMComAT.RxRing.h"
 
 #define _SIM808_DEBUG _DEBUG
 
+#ifndef SIMCOMAT_STATS
+	#define SIMCOMAT_STATS 0			///< Set to 1 to record per command statistics, see SIMComAT::dumpStats.
+#endif
+#ifndef SIMCOMAT_STATS_COMMANDS
+	#define SIMCOMAT_STATS_COMMANDS 8	///< Commands recorded separately, the last entry gathering all the others.
+#endif
+
+#include "SIMComAT.Stats.h"
+
 #if _SIM808_DEBUG
+	#include <ArduinoLog.h>
+
 	#define SIM808_PRINT(...) _debug.verbose(__VA_ARGS__)
-	#define SIM808_PRINT_CHAR(x) Serial.print((char)x)
+	#define SIM808_PRINT_BYTES(buffer, size) Serial.write(buffer, size)
 	#define SIM808_PRINT_P(fmt, ...) _debug.verbose(S_F(fmt "\n"), __VA_ARGS__)
 	#define SIM808_PRINT_SIMPLE_P(fmt) _debug.verbose(S_F(fmt "\n"))
 
@@ -16,7 +28,7 @@
 	#define SENDARROW _debug.verbose(S_F("\n-->"))
 #else
 	#define SIM808_PRINT(...)
-	#define SIM808_PRINT_CHAR(x)
+	#define SIM808_PRINT_BYTES(buffer, size)
 	#define SIM808_PRINT_P(x, ...)
 	#define SIM808_PRINT_SIMPLE_P(x)
 	
@@ -24,25 +36,212 @@
 	#define SENDARROW
 #endif // _DEBUG
 
+#if SIMCOMAT_STATS
+	#define SIMCOMAT_STATS_BEGIN(key) _stats.begin(key)
+	#define SIMCOMAT_STATS_QUEUE(key) _stats.queue(key)
+	#define SIMCOMAT_STATS_LINE() _stats.beginQueued()
+	#define SIMCOMAT_STATS_SENT(count) _stats.sent(count)
+	#define SIMCOMAT_STATS_RECEIVED(c) _stats.received(c)
+	#define SIMCOMAT_STATS_RESULT(timeout, error) _stats.result(timeout, error)
+#else
+	#define SIMCOMAT_STATS_BEGIN(key)
+	#define SIMCOMAT_STATS_QUEUE(key)
+	#define SIMCOMAT_STATS_LINE()
+	#define SIMCOMAT_STATS_SENT(count)
+	#define SIMCOMAT_STATS_RECEIVED(c)
+	#define SIMCOMAT_STATS_RESULT(timeout, error)
+#endif // SIMCOMAT_STATS
+
 #if SIZE_MAX > UINT16_MAX
 	#define NEED_SIZE_T_OVERLOADS
+	typedef size_t ATDataSize;			///< Size of data exchanged with the device, such as HTTP bodies.
+#else
+	#define NEED_DATA_SIZE_OVERLOADS
+	typedef uint32_t ATDataSize;		///< Size of data exchanged with the device, such as HTTP bodies.
 #endif
 
-#define BUFFER_SIZE 64
+#ifndef SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE
+	#define SIMCOMAT_DEFAULT_REPLY_BUFFER_SIZE 64	///< Size of the reply buffer of SIM808Buffered<>.
+#endif
 #define SIMCOMAT_DEFAULT_TIMEOUT 1000
+#define SIMCOMAT_MAX_URC_HANDLERS 4
+#define SIMCOMAT_MAX_COMMAND_LINE 556	///< Maximum length of a command line accepted by the device.
+#define SIMCOMAT_LINE_BUFFER_SIZE 32	///< Size of the stack buffer used to assemble command lines.
+#define SIMCOMAT_TX_BUFFER_SIZE 32		///< Size of the buffer coalescing the bytes written to the device. Larger writes go straight through.
+#define SIMCOMAT_RESULT_FAILED -2		///< Result of a response ended by a final error result code that was not awaited.
+
+#if SIMCOMAT_MAX_URC_HANDLERS > 12
+	#error "SIMCOMAT_MAX_URC_HANDLERS cannot exceed 12"
+#endif
+
+/**
+ * State of the response currently awaited by the AT engine.
+ */
+enum class SIMComATResponseStatus : uint8_t
+{
+	Idle = 0,		///< No response has been awaited yet.
+	Pending = 1,	///< A response is awaited. poll() must be called to make progress.
+	Done = 2,		///< One of the awaited tokens has been received. See responseResult().
+	Timeout = 3		///< The awaited response has not been received in time.
+};
+
+/**
+ * Called when an asynchronous command completes, with the index of the received token,
+ * SIMCOMAT_RESULT_FAILED if it failed with another error, or -1 if the command timed out.
+ */
+typedef void (*SIMComATResponseCallback)(int8_t result);
+
+/**
+ * Called with an unsolicited line, directly from the reply buffer.
+ * The line is NUL terminated, without its trailing new line.
+ */
+typedef void (*SIMComATUrcHandler)(const char* line, size_t length);
+
+/**
+ * Assembles a command line in a small stack buffer, written to output in as few writes as possible.
+ */
+class SIMComATLine
+{
+private:
+	Print* _output;
+	char _buffer[SIMCOMAT_LINE_BUFFER_SIZE];
+	uint8_t _length;
+
+public:
+	SIMComATLine(Print& output) : _output(&output), _length(0) { }
+
+	void append(char c)
+	{
+		if(_length == SIMCOMAT_LINE_BUFFER_SIZE) flush();
+		_buffer[_length++] = c;
+	}
+	void append(const char* str);
+	void append_P(const char* str);
+	/**
+	 * Append the decimal representation of value, without any printf engine.
+	 */
+	void appendUnsigned(uint32_t value);
+	template<typename T> void appendNumber(T value)
+	{
+		if(value < 0) {
+			append('-');
+			appendUnsigned((uint32_t)0 - (uint32_t)value);
+		}
+		else appendUnsigned((uint32_t)value);
+	}
+	/**
+	 * Write the buffered characters to the output.
+	 */
+	void flush();
+};
 
 class SIMComAT : public Stream
 {
 private:
+	ATConstStr _wantedTokens[4];
+	ATConstStr _urcPrefixes[SIMCOMAT_MAX_URC_HANDLERS];
+	SIMComATUrcHandler _urcHandlers[SIMCOMAT_MAX_URC_HANDLERS];
+	Print* _urcOutputs[SIMCOMAT_MAX_URC_HANDLERS];
+	Print* _lineOutput;
+	Print* _dataOutput;
+	size_t _dataRemaining;
+	uint16_t _wantedMask;
+	uint16_t _urcMask;
+	uint32_t _responseStart;
+	uint16_t _responseTimeout;
+	size_t _lineLength;
+	uint16_t _lineCandidates;
+	uint16_t _lineMatches;
+	int8_t _responseResult;
+	int16_t _errorCode;
+	SIMComATResponseStatus _responseStatus;
+	SIMComATResponseCallback _responseCallback;
+	uint8_t _responseId;		///< Changes with each response awaited.
+
+	size_t _batchLength;
+	uint16_t _batchTimeout;
+	bool _batchFailed;
+	bool _measuring;
+	size_t _measured;
+
+	uint8_t _txBuffer[SIMCOMAT_TX_BUFFER_SIZE];
+	uint8_t _txLength;
+
+#if SIMCOMAT_STATS
+	SIMComATStats _stats;
+
+	/**
+	 * Get the key commands are recorded under : their first PROGMEM token, or NULL when sent from RAM.
+	 */
+	static const char* statsKey() { return TOKEN_AT; }
+	template<typename T, typename... Args> static const char* statsKey(T head, Args... tail) { return statsKeyOf(head); }
+	template<typename T> static const char* statsKeyOf(T value) { return NULL; }
+	static const char* statsKeyOf(ATConstStr token) { return TO_P(token); }
+#endif
+
+	/**
+	 * Get the nth token matched against incoming lines : awaited tokens first, then unsolicited prefixes.
+	 */
+	ATConstStr lineToken(uint8_t index) { return index < 4 ? _wantedTokens[index] : _urcPrefixes[index - 4]; }
+	/**
+	 * Read the available characters line by line, dispatching unsolicited lines to their handlers.
+	 * Returns as soon as an awaited line is read with the index of its matching token, or -1.
+	 */
+	int8_t readLines();
+	/**
+	 * Advance the match of the current line against the awaited tokens with
+	 * the next character received, before it is appended to the reply buffer.
+	 */
+	void matchNext(char c);
+	/**
+	 * Terminate the line currently held in the reply buffer and reset the matching state.
+	 * Returns the index of the matching token, or -1.
+	 */
+	int8_t endLine();
+	/**
+	 * Get a boolean indicating wether or not the line held in the reply buffer is a final error result code.
+	 */
+	bool isFinalError();
+	/**
+	 * Strip the new line from the end of the line held in the reply buffer, and return its new length.
+	 */
+	size_t trimLine(size_t length);
+	SIMComATResponseStatus endResponse(SIMComATResponseStatus status, int8_t result);
+
+	/**
+	 * Open room for the next batched command of the given length, sending the
+	 * current line first if the command would not fit in it.
+	 */
+	bool nextBatchCommand(size_t length);
+	/**
+	 * Terminate the current batch line and wait for its result.
+	 */
+	bool sendBatchLine();
+
+	/**
+	 * Write the bytes held in the transmit buffer to the device at once.
+	 * Called at the end of each line, and before anything is read.
+	 */
+	void flushTx()
+	{
+		if(!_txLength) return;
+
+		SIM808_PRINT_BYTES(_txBuffer, _txLength);
+		_port->write(_txBuffer, _txLength);
+		_txLength = 0;
+	}
 
 protected:
 	Stream* _port;
-	Logging _output;
+	SIMComATRxRing* _rxRing;
 #if _SIM808_DEBUG
 	Logging _debug;
 #endif
 
-	char replyBuffer[BUFFER_SIZE];
+	char* replyBuffer;		///< Holds the line being read, see SIM808Buffered.
+	size_t replyBufferSize;
+
+	SIMComAT(char* replyBuffer, size_t replyBufferSize);
 	
 	template<typename T> void writeStream(T last)
 	{
@@ -57,20 +256,101 @@ protected:
 
 	template<typename... Args> void sendAT(Args... cmd)
 	{
+		SIMCOMAT_STATS_BEGIN(statsKey(cmd...));
 		SENDARROW;
 		writeStream(TO_F(TOKEN_AT), cmd..., TO_F(TOKEN_NL));
 	}
+	/**
+	 * Send an already formatted command held in RAM.
+	 */
+	void sendRawAT(const char* cmd)
+	{
+		SIMCOMAT_STATS_BEGIN(NULL);
+		SENDARROW;
+		writeStream(TO_F(TOKEN_AT), cmd, TO_F(TOKEN_NL));
+	}
 
-	template<typename T, typename... Args> void sendFormatAT(T format, Args... args)
+	/**
+	 * Send a command formatted from a PROGMEM format. See writeFormat.
+	 */
+	void sendFormatAT(ATConstStr format, ...);
+	/**
+	 * Append format to line, substituting %d (int), %l (long), %s (string) and %S (PROGMEM string) with args.
+	 */
+	void writeFormat(SIMComATLine& line, ATConstStr format, va_list args);
+
+	/**
+	 * Send command, followed by its parameters separated by ','. Strings are quoted, integers written as is.
+	 * The whole line is assembled before being written to the device. See AT_COMMAND_SPEC.
+	 */
+	template<typename... Args> void sendCommandAT(ATCommand command, Args... params)
 	{
+		SIMComATLine line(*this);
+
+		SIMCOMAT_STATS_BEGIN(command.text);
 		SENDARROW;
-		writeStream(TO_F(TOKEN_AT));
-		_output.verbose(format, args...);
-		writeStream(TO_F(TOKEN_NL));
+		line.append_P(TOKEN_AT);
+		line.append_P(command.text);
+		writeParameters(line, params...);
+		line.append_P(TOKEN_NL);
+		line.flush();
+	}
+
+	void writeParameters(SIMComATLine& line) { }
+
+	template<typename T, typename... Args> void writeParameters(SIMComATLine& line, T head, Args... tail)
+	{
+		writeParameter(line, head);
+		if(sizeof...(tail)) line.append(',');
+		writeParameters(line, tail...);
+	}
+
+	template<typename T> void writeParameter(SIMComATLine& line, T value) { line.appendNumber(value); }
+	void writeParameter(SIMComATLine& line, const char* value);
+	void writeParameter(SIMComATLine& line, char* value) { writeParameter(line, (const char*)value); }
+#if defined(__AVR__)
+	void writeParameter(SIMComATLine& line, ATConstStr value);
+#endif
+
+	/**
+	 * Start queuing commands to be sent as few lines as possible, separated by ';'.
+	 * Only commands answering a plain OK / ERROR can be batched.
+	 * The timeout is applied to each line sent.
+	 */
+	void beginBatch(uint16_t timeout = SIMCOMAT_DEFAULT_TIMEOUT);
+	/**
+	 * Queue a command in the current batch. Returns false if the batch has already failed.
+	 */
+	template<typename... Args> bool batchAT(Args... cmd)
+	{
+		_measured = 0;
+		_measuring = true;
+		writeStream(cmd...);
+		_measuring = false;
+
+		SIMCOMAT_STATS_QUEUE(statsKey(cmd...));
+		if(!nextBatchCommand(_measured)) return false;
+		writeStream(cmd...);
+		return true;
 	}
+	/**
+	 * Queue a formatted command in the current batch. Returns false if the batch has already failed.
+	 */
+	bool batchFormatAT(ATConstStr format, ...);
+	/**
+	 * Send what remains of the current batch and wait for its result.
+	 * Returns true if every command of the batch succeeded.
+	 */
+	bool endBatch();
+	/**
+	 * Send what remains of the current batch and start waiting for its result, read from pollResponse(), without blocking.
+	 * Returns false if the batch has already failed, or if nothing is left to send.
+	 */
+	bool endBatchAsync();
 
 	/**
-	 * Read and discard all content already waiting to be parsed. 
+	 * Read all content already waiting to be parsed. Unsolicited lines are dispatched
+	 * to their handlers, everything else is discarded.
 	 */
 	void flushInput();
 	/**
@@ -79,6 +359,41 @@ protected:
 	 * 
 	 */
 	size_t readNext(char * buffer, size_t size, uint16_t * timeout = NULL, char stop = 0);
+	/**
+	 * Read at max size chars straight into output, until nothing is received for timeout ms
+	 * or the stop character is encountered. stop is optional.
+	 * Returns the number of chars read.
+	 */
+	size_t readNext(Print& output, size_t size, uint16_t timeout, char stop = 0);
+	/**
+	 * Start waiting for a line beginning with one of the provided tokens, without blocking.
+	 * The response is then read line by line from pollResponse().
+	 * A NULL s1 matches any line with content.
+	 */
+	void beginResponse(uint16_t timeout,
+		ATConstStr s1 = TO_F(TOKEN_OK),
+		ATConstStr s2 = TO_F(TOKEN_ERROR),
+		ATConstStr s3 = NULL,
+		ATConstStr s4 = NULL);
+	/**
+	 * Consume the bytes already waiting on the port and advance the awaited response.
+	 * Never blocks.
+	 */
+	SIMComATResponseStatus pollResponse();
+	/**
+	 * Start waiting for the response of command, without blocking. See waitResponse(ATCommand).
+	 */
+	void beginResponse(ATCommand command)
+	{
+		if(command.response) beginResponse(command.timeout, TO_F(command.response));
+		else beginResponse(command.timeout);
+	}
+	/**
+	 * Wait for a line beginning with one of the provided tokens, and return the index
+	 * of the matching token, or -1 if none has been received before the timeout.
+	 * Final error result codes (ERROR, +CME ERROR, +CMS ERROR, NO CARRIER, SEND FAIL...) that are not
+	 * awaited end the wait right away with SIMCOMAT_RESULT_FAILED. See errorCode().
+	 */
 	int8_t waitResponse(
 		ATConstStr s1 = TO_F(TOKEN_OK),
 		ATConstStr s2 = TO_F(TOKEN_ERROR),
@@ -92,6 +407,16 @@ protected:
 		ATConstStr s2 = TO_F(TOKEN_ERROR),
 		ATConstStr s3 = NULL,
 		ATConstStr s4 = NULL);
+	/**
+	 * Wait for the response of command, within its timeout : the line starting with its
+	 * response prefix (0) or ERROR (1), or OK (0) / ERROR (1) if it has no response prefix.
+	 */
+	int8_t waitResponse(ATCommand command)
+	{
+		return command.response ?
+			waitResponse(command.timeout, TO_F(command.response)) :
+			waitResponse(command.timeout);
+	}
 		
 	/**
 	 * Read the current response line and copy it in response. Start at replyBuffer + shift
@@ -120,6 +445,12 @@ protected:
 	 * Parse the nth field of a string as a size_t.
 	 */
 	bool parse(const char* str, char divider, uint8_t index, size_t* result);
+#endif
+#if defined(NEED_DATA_SIZE_OVERLOADS)
+	/**
+	 * Parse the nth field of a string as a ATDataSize.
+	 */
+	bool parse(const char* str, char divider, uint8_t index, ATDataSize* result);
 #endif
 	/**
 	 * Parse the nth field of a string as a int16_t.
@@ -148,6 +479,12 @@ protected:
 	 */
 	bool parseReply(char divider, uint8_t index, size_t* result) { return parse(replyBuffer, divider, index, result); }
 #endif	
+#if defined(NEED_DATA_SIZE_OVERLOADS)
+	/**
+	 * Parse the nth field of the reply buffer as a ATDataSize.
+	 */
+	bool parseReply(char divider, uint8_t index, ATDataSize* result) { return parse(replyBuffer, divider, index, result); }
+#endif
 	/**
 	 * Parse the nth field of the reply buffer as a int16_t.
 	 */
@@ -157,6 +494,59 @@ protected:
 	 */
 	bool parseReply(char divider, uint8_t index, float* result) { return parse(replyBuffer, divider, index, result); }
 
+	/**
+	 * Parse the consecutive integer fields of the reply buffer, starting from the first one,
+	 * in a single pass. A NULL result skips its field.
+	 * Returns false if a field is missing, is not a number or does not fit in its result.
+	 */
+	template<typename... Args> bool parseReplyFields(char divider, Args... results)
+	{
+		const char* p = find(replyBuffer, divider, 0);
+		return parseFields(p, divider, results...);
+	}
+
+	bool parseFields(const char*& p, char divider) { return true; }
+
+	template<typename T, typename... Args> bool parseFields(const char*& p, char divider, T* head, Args... tail)
+	{
+		return parseField(p, divider, head) && parseFields(p, divider, tail...);
+	}
+
+	template<typename T> bool parseField(const char*& p, char divider, T* result)
+	{
+		static_assert(sizeof(T) <= sizeof(uint32_t) || (T)-1 > 0, "Signed fields are limited to 32 bits");
+
+		bool negative;
+		uint32_t value;
+
+		if(!parseField(p, divider, &negative, &value)) return false;
+
+		if((T)-1 > 0) {
+			if(negative || value > (T)~(T)0) return false;
+		}
+		// the magnitude of the lowest value is one more than the highest
+		else if(value > ((uint32_t)1 << (sizeof(T) * 8 - 1)) - !negative) return false;
+
+		if(result) *result = negative ? (T)(0 - value) : (T)value;
+		return true;
+	}
+	/**
+	 * Read the integer field starting at p, and move p to the next one, or to NULL after the last one.
+	 * Returns false if the field is missing, is not a number or does not fit in 32 bits.
+	 */
+	bool parseField(const char*& p, char divider, bool* negative, uint32_t* value);
+
+	/**
+	 * Hand the next length bytes received over to output as they are, before reading lines again.
+	 * Meant to be called from an unsolicited result code output announcing binary data.
+	 */
+	void receiveData(Print& output, size_t length);
+	/**
+	 * Called with every line that is neither awaited nor handled by a registered handler,
+	 * without its new line. Must not send commands.
+	 */
+	virtual void unhandledLine(const char* line, size_t length) { }
+
 	/**
 	 * Perform the minmum commands needed to get the device communication up and running.
 	 */
@@ -166,14 +556,111 @@ public:
 	 * Begin communicating with the device.
 	 */
 	void begin(Stream& port);
+	/**
+	 * Begin communicating with the device, reading what it sends from rxRing instead of port.
+	 * rxRing must be filled by the sketch, from the UART interrupt for instance.
+	 */
+	void begin(Stream& port, SIMComATRxRing& rxRing);
+
+	/**
+	 * Send an already formatted command and return immediately. Progress is made by calling poll(),
+	 * until the command completes with either OK (0) or ERROR (1), or times out (-1).
+	 * Returns false if another command is still pending.
+	 */
+	bool sendCommandAsync(const char* cmd, SIMComATResponseCallback callback = NULL, uint16_t timeout = SIMCOMAT_DEFAULT_TIMEOUT);
+	/**
+	 * Consume the bytes available on the port and advance the pending command, if any.
+	 * Meant to be called from loop(). Never blocks.
+	 */
+	SIMComATResponseStatus poll();
+	/**
+	 * Get the state of the last command sent.
+	 */
+	SIMComATResponseStatus responseStatus() { return _responseStatus; }
+	/**
+	 * Get the index of the token that completed the last command, or -1 if it timed out.
+	 */
+	int8_t responseResult() { return _responseResult; }
+	/**
+	 * Get the identifier of the response currently awaited, which changes with each command sent.
+	 * Tells whether the response being read is still the one a caller started waiting for.
+	 */
+	uint8_t responseId() { return _responseId; }
+	/**
+	 * Get the numeric code of the +CME ERROR or +CMS ERROR that ended the last response,
+	 * or -1 if it did not end with one. Requires numeric error reporting (AT+CMEE=1).
+	 */
+	int16_t errorCode() { return _errorCode; }
+
+	/**
+	 * Register a handler called with every line starting with prefix that is not an awaited response,
+	 * including while a command is waiting for its response. Handlers must not send commands.
+	 * Returns false if SIMCOMAT_MAX_URC_HANDLERS handlers are already registered.
+	 */
+	bool registerUrcHandler(ATConstStr prefix, SIMComATUrcHandler handler);
+	/**
+	 * Register an output receiving the rest of every line starting with prefix that is not an awaited response,
+	 * character by character as it is received, instead of being held in the reply buffer.
+	 * Returns false if SIMCOMAT_MAX_URC_HANDLERS handlers are already registered.
+	 */
+	bool registerUrcHandler(ATConstStr prefix, Print& output);
+	/**
+	 * Remove the handler or output registered for prefix.
+	 */
+	void unregisterUrcHandler(ATConstStr prefix);
+
+#if SIMCOMAT_STATS
+	/**
+	 * Write the latency, byte count and outcome statistics recorded for each command sent so far.
+	 */
+	void dumpStats(Print& output, SIMComATStatsFormat format = SIMComATStatsFormat::Csv) { _stats.dump(output, format); }
+	/**
+	 * Forget the statistics recorded so far.
+	 */
+	void resetStats() { _stats.reset(); }
+#endif
 
 #pragma region Stream implementation
 
-	int available() { return _port->available(); }
-	size_t write(uint8_t x) { SIM808_PRINT_CHAR(x); return _port->write(x); }
-	int read() { return _port->read(); }
-	int peek() { return _port->peek(); }
-	void flush() { return _port->flush(); }
+	using Print::write;
+
+	int available()
+	{
+		flushTx();
+		return _rxRing ? _rxRing->available() : _port->available();
+	}
+	size_t write(uint8_t x) 
+	{ 
+		if(_measuring) {
+			_measured++;
+			return 1;
+		}
+
+		SIMCOMAT_STATS_SENT(1);
+		if(_txLength == SIMCOMAT_TX_BUFFER_SIZE) flushTx();
+		_txBuffer[_txLength++] = x;
+		if(x == '\n') flushTx();
+
+		return 1;
+	}
+	size_t write(const uint8_t* buffer, size_t size);
+	int read()
+	{
+		flushTx();
+		int c = _rxRing ? _rxRing->read() : _port->read();
+		SIMCOMAT_STATS_RECEIVED(c);
+		return c;
+	}
+	int peek()
+	{
+		flushTx();
+		return _rxRing ? _rxRing->peek() : _port->peek();
+	}
+	void flush()
+	{
+		flushTx();
+		return _port->flush();
+	}
 	
 #pragma endregion
 